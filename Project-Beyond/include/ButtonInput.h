@@ -0,0 +1,83 @@
+#ifndef BUTTON_INPUT_H
+#define BUTTON_INPUT_H
+
+#include <Arduino.h>
+#include "SpscQueue.h"
+#include "FastPin.h"
+
+#define BUTTON_QUEUE_SIZE 16
+#define BUTTON_DEBOUNCE_US 20000UL
+
+enum Button
+{
+    BUTTON_PRESSURE,
+    BUTTON_MODE,
+    BUTTON_COUNT
+};
+
+struct ButtonEvent
+{
+    uint8_t button;
+    uint8_t level;
+    uint32_t time; // micros() at the edge
+};
+
+// Edge interrupts on both buttons push timestamped raw events into a
+// lock-free queue; poll() drains it from the main loop and debounces by
+// comparing timestamps. Edges that arrive while interrupts are disabled
+// (e.g. during strip.show()) are latched by the hardware and queued as soon
+// as interrupts are re-enabled.
+class ButtonInput
+{
+private:
+    struct ButtonState
+    {
+        uint8_t stable;
+        uint8_t raw;
+        uint32_t lastEdge;
+        uint32_t lastAccept;
+    };
+
+    ButtonState states[BUTTON_COUNT];
+
+    bool accept(uint8_t button, uint8_t level, uint32_t time, ButtonEvent &change);
+    void begin(uint8_t pressurePin, uint8_t modePin, void (*onPressure)(), void (*onMode)());
+
+    static void pushEdge(uint8_t button, uint8_t level);
+
+    template <uint8_t Button, uint8_t Pin>
+    static void onEdge()
+    {
+        pushEdge(Button, FastPin<Pin>::read());
+    }
+
+public:
+    // Pins are template arguments so each edge interrupt reads its pin
+    // with a direct port access
+    template <uint8_t PressurePin, uint8_t ModePin>
+    void begin()
+    {
+        begin(PressurePin, ModePin, onEdge<BUTTON_PRESSURE, PressurePin>, onEdge<BUTTON_MODE, ModePin>);
+    }
+
+    // Returns true and fills change for each debounced level change. Call
+    // repeatedly until it returns false.
+    bool poll(ButtonEvent &change, uint32_t now);
+
+    bool isDown(Button button) const
+    {
+        return states[button].stable == HIGH;
+    }
+
+    // Queues an edge for any button whose level changed while the edge
+    // interrupts could not see it, e.g. in power-save sleep
+    void resync();
+
+    // False while an edge is queued or a level is waiting out its debounce
+    // interval, i.e. while poll() still has work to do
+    bool isSettled() const;
+
+    uint16_t getDropped() const;
+};
+
+#endif
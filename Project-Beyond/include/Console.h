@@ -0,0 +1,40 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+
+#define CONSOLE_LINE_SIZE 40      // Longest accepted line, including the terminator
+#define CONSOLE_MAX_ARGS 4        // Command word plus arguments; extra words are ignored
+#define CONSOLE_BYTES_PER_POLL 16 // Bounds the work one poll() does under a flood
+
+// Line reader for the serial console. poll() moves at most
+// CONSOLE_BYTES_PER_POLL bytes from the stream into a fixed buffer and,
+// once a line ends, splits it in place on spaces. Nothing is allocated.
+// Lines that overflow the buffer are discarded up to their end.
+class Console
+{
+private:
+    Stream &stream;
+    char line[CONSOLE_LINE_SIZE];
+    uint8_t length;
+    bool overflowed;
+    uint16_t discarded;
+
+    uint8_t tokenize(char **argv);
+
+public:
+    explicit Console(Stream &source) : stream(source), length(0), overflowed(false), discarded(0) {}
+
+    // Returns the word count of a completed line and points argv (at least
+    // CONSOLE_MAX_ARGS entries) into the buffer, which stays valid until the
+    // next poll(). Returns 0 while no non-empty line is complete.
+    uint8_t poll(char **argv);
+
+    // Lines thrown away for being too long
+    uint16_t getDiscarded() const
+    {
+        return discarded;
+    }
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef FAST_PIN_H
+#define FAST_PIN_H
+
+#include <Arduino.h>
+
+// Digital read for a pin known at compile time. On the ATmega328P the port
+// and mask fold to constants, so read() is a single IN and AND instead of
+// digitalRead()'s table lookups and timer check (~60 cycles). Elsewhere it
+// falls back to digitalRead().
+template <uint8_t Pin>
+struct FastPin
+{
+#if defined(__AVR_ATmega328P__)
+    static uint8_t read()
+    {
+        // D0-D7 are PORTD, D8-D13 PORTB, A0-A5 (14-19) PORTC
+        uint8_t port = Pin < 8 ? PIND : Pin < 14 ? PINB : PINC;
+        return port & _BV(Pin < 8 ? Pin : Pin < 14 ? Pin - 8 : Pin - 14) ? HIGH : LOW;
+    }
+#else
+    static uint8_t read()
+    {
+        return digitalRead(Pin);
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef KNOB_INPUT_H
+#define KNOB_INPUT_H
+
+#include <Arduino.h>
+
+#define KNOB_MAX 1023
+#define KNOB_OVERSAMPLE 16  // Raw conversions summed per decimated sample
+#define KNOB_EMA_SHIFT 3    // Smoothing factor 1/8 on the decimated samples
+#define KNOB_HYSTERESIS 12  // Counts a reading must move past a bucket edge
+
+// Knob reader backed by the ADC in free-running mode. The conversion-complete
+// interrupt oversamples, decimates to 12 bits and applies an integer
+// exponential moving average, so read() returns a settled value without
+// waiting on a conversion. Only one instance may exist.
+class KnobInput
+{
+public:
+    void begin(uint8_t pin);
+
+    // Stops the ADC and its interrupt; begin() starts it again
+    void end();
+
+    // Filtered reading on the same 0..KNOB_MAX scale as analogRead()
+    uint16_t read() const;
+
+    // Equivalent of map(read(), 0, KNOB_MAX, low, high), but keeps returning
+    // current until the reading is KNOB_HYSTERESIS counts past the edge of
+    // current's bucket, so noise at a boundary does not make it flicker
+    int bucket(int current, int low, int high) const;
+};
+
+#endif
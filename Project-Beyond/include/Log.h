@@ -0,0 +1,89 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include "LogMessages.h"
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Override with -D LOG_LEVEL=... in build_flags. Messages above it are
+// compiled out; logSetLevel() moves the threshold at run time within it.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_BUFFER_SIZE 64 // Bytes; must be a power of two
+#define LOG_SYNC 0xA5      // First byte of every record, never valid ASCII
+
+// Records are LOG_SYNC, message id, argument count, then each argument as a
+// little-endian int16. They are queued in RAM and written to Serial by
+// logDrain() only as fast as the TX buffer accepts them, so logging never
+// blocks. A record that does not fit is dropped whole and counted.
+void logWrite(uint8_t id, uint8_t argc, int16_t a, int16_t b, int16_t c);
+
+// Writes queued bytes without blocking; call when the loop is otherwise idle
+void logDrain();
+
+// Blocks until the queue is empty; call before printing plain text so it
+// does not land in the middle of a record
+void logFlush();
+
+uint16_t logDropped();
+
+extern uint8_t logLevel;
+
+inline void logSetLevel(uint8_t level)
+{
+    logLevel = level > LOG_LEVEL ? LOG_LEVEL : level;
+}
+
+bool logPending();
+
+inline void logRecord(uint8_t id) { logWrite(id, 0, 0, 0, 0); }
+inline void logRecord(uint8_t id, int16_t a) { logWrite(id, 1, a, 0, 0); }
+inline void logRecord(uint8_t id, int16_t a, int16_t b) { logWrite(id, 2, a, b, 0); }
+inline void logRecord(uint8_t id, int16_t a, int16_t b, int16_t c) { logWrite(id, 3, a, b, c); }
+
+#define LOG_DISCARD(...) \
+    do                   \
+    {                    \
+    } while (0)
+
+#define LOG_AT(level, ...)          \
+    do                              \
+    {                               \
+        if (logLevel >= (level))    \
+        {                           \
+            logRecord(__VA_ARGS__); \
+        }                           \
+    } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISCARD()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISCARD()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD()
+#endif
+
+#endif
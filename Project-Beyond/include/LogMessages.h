@@ -0,0 +1,34 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+// Catalogue of log messages. Records carry only the index of the entry and
+// its integer arguments; tools/decode_log.py parses this file to turn them
+// back into text, substituting {} with the arguments in order. Append new
+// entries at the end so existing ids stay stable.
+#define LOG_MESSAGES(X)                                                                                    \
+    X(LOG_SERIAL_STARTED, "Serial communication started at 9600 baud")                                     \
+    X(LOG_MODE_WAKEUP_TIME, "Mode switched to: SET_WAKEUP_TIME")                                           \
+    X(LOG_MODE_RED_LIGHT_TIME, "Mode switched to: SET_RED_LIGHT_TIME")                                     \
+    X(LOG_WAKEUP_TIME_SET, "Wakeup Time set to: {}")                                                       \
+    X(LOG_RED_LIGHT_TIME_SET, "Red Light Time set to: {}")                                                 \
+    X(LOG_PLAYING_NOISE, "Playing noise from MP3 player at volume {}")                                     \
+    X(LOG_PRESSURE_PRESSED, "Pressure button pressed: Playing noise and emitting red light")               \
+    X(LOG_DIMMING_STEP, "Dimming... Brightness: {}, Volume: {}")                                           \
+    X(LOG_DIMMING_COMPLETE, "Dimming complete: Light and volume turned off. Good night!")                  \
+    X(LOG_SUNRISE_START, "Starting brighting process...")                                                  \
+    X(LOG_SUNRISE_STEP, "Volume: {}, Red: {}, Green: {}")                                                  \
+    X(LOG_HOLDING, "Program completed. Holding down button.")                                              \
+    X(LOG_PRESSURE_RELEASED, "Pressure button released: Light and volume turned off. Returning to white light.") \
+    X(LOG_SETTINGS_RESTORED, "Settings restored: wakeupTime {}, redLightTime {}, musicIndex {}")           \
+    X(LOG_WAKEUP_SCHEDULED, "Sunrise scheduled in {} min")                                                 \
+    X(LOG_CLOCK_TRIM, "Clock synced to RTC, trim {} ppm")
+
+#define LOG_MESSAGE_ID(id, text) id,
+
+enum LogMessage
+{
+    LOG_MESSAGES(LOG_MESSAGE_ID)
+    LOG_MESSAGE_COUNT
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+#define POWER_SAVE_MIN_MS 200      // Shorter waits use idle mode only
+#define POWER_SAVE_MAX_PRESCALE 6  // Longest watchdog period in power-save, ~1 s
+#define POWER_WDT_BASE_US 16000UL  // Nominal watchdog period at prescale 0
+#define POWER_AWAKE_HOLD_MS 30000UL // Idle mode only for this long after console input
+
+struct PowerStats
+{
+    uint32_t idleMs; // Time in SLEEP_MODE_IDLE
+    uint32_t saveMs; // Time in SLEEP_MODE_PWR_SAVE, from the calibrated watchdog
+    uint16_t saveWakes;
+};
+
+// Called by the main loop when nothing is due before deadline (a millis()
+// value). Returns at the deadline, or earlier once powerWake() is called
+// from an interrupt.
+//
+// Idle mode keeps Timer0 running, so millis() stays exact and any
+// interrupt ends the sleep within one Timer0 tick. With allowSave, waits of
+// POWER_SAVE_MIN_MS or more are slept in power-save instead. The Uno has no
+// Timer2 crystal, so the watchdog wakes it, and millis() is advanced by
+// watchdog periods measured against Timer0 just before sleeping. The
+// button pins wake it through a pin change. The caller must stop the
+// free-running ADC first.
+//
+// Serial input ends an idle-mode wait as soon as the byte is received. In
+// power-save the USART is stopped, so a start bit on RXD wakes the CPU
+// through a pin change instead; that byte is lost or garbled (the crystal
+// takes about 1 ms, a whole byte at 9600 baud, to restart), and waits stay
+// in idle mode for POWER_AWAKE_HOLD_MS so the rest of the line is read.
+// Console users should press Enter once before typing a command. A byte
+// from the MP3 module wakes it the same way.
+//
+// The host build hands the wait to the simulator, which skips straight to
+// the deadline or the next scripted input.
+void powerIdleUntil(uint32_t deadline, bool allowSave);
+
+// Ends the current powerIdleUntil() early; safe to call from an ISR
+void powerWake();
+
+// Keeps waits out of power-save for POWER_AWAKE_HOLD_MS from now; a wait
+// that would have used it ends with the hold instead
+void powerStayAwake();
+
+const PowerStats &powerStats();
+void powerPrintStats(Print &out);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef RTC_SOURCE_H
+#define RTC_SOURCE_H
+
+#include <Arduino.h>
+
+// Reference time source such as a battery-backed RTC module. The host
+// build supplies a mock that follows the simulator's true time.
+class RtcSource
+{
+public:
+    // Fills seconds and returns true, or returns false if the device is
+    // missing or has not been set
+    virtual bool read(uint32_t &seconds) = 0;
+};
+
+// The board's RTC, or null if none is fitted
+RtcSource *boardRtc();
+
+#endif
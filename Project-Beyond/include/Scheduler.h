@@ -0,0 +1,157 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#define SCHEDULER_MAX_TASKS 8
+#define SCHEDULER_OVERRUN_SLACK_MS 2 // A task started later than this counts as an overrun
+
+typedef void (*TaskCallback)(void *context);
+
+struct Task
+{
+    const __FlashStringHelper *name;
+    TaskCallback callback;
+    void *context;
+    uint32_t period;   // 0 for one-shot tasks
+    uint32_t deadline; // millis() value at which the task is next due
+    bool active;
+    uint16_t runs;
+    uint16_t overruns;
+    uint32_t maxLateness;
+};
+
+// Cooperative millis()-based scheduler. Tasks never block; run() dispatches
+// every task whose deadline has passed and returns immediately otherwise.
+class Scheduler
+{
+private:
+    Task tasks[SCHEDULER_MAX_TASKS];
+    uint8_t taskCount;
+
+public:
+    Scheduler() : taskCount(0) {}
+
+    // Registers a task slot and returns its id, or -1 if the table is full
+    int8_t add(const __FlashStringHelper *name, TaskCallback callback, void *context)
+    {
+        if (taskCount >= SCHEDULER_MAX_TASKS)
+        {
+            return -1;
+        }
+        Task &task = tasks[taskCount];
+        task.name = name;
+        task.callback = callback;
+        task.context = context;
+        task.period = 0;
+        task.deadline = 0;
+        task.active = false;
+        task.runs = 0;
+        task.overruns = 0;
+        task.maxLateness = 0;
+        return taskCount++;
+    }
+
+    // Runs the task every period ms, first after firstDelay ms
+    void startPeriodic(int8_t id, uint32_t period, uint32_t firstDelay, uint32_t now)
+    {
+        tasks[id].period = period;
+        tasks[id].deadline = now + firstDelay;
+        tasks[id].active = true;
+    }
+
+    // Runs the task once, delay ms from now
+    void startOnce(int8_t id, uint32_t delay, uint32_t now)
+    {
+        tasks[id].period = 0;
+        tasks[id].deadline = now + delay;
+        tasks[id].active = true;
+    }
+
+    void cancel(int8_t id)
+    {
+        tasks[id].active = false;
+    }
+
+    bool isActive(int8_t id) const
+    {
+        return tasks[id].active;
+    }
+
+    void run(uint32_t now)
+    {
+        for (uint8_t i = 0; i < taskCount; i++)
+        {
+            Task &task = tasks[i];
+            if (!task.active || (int32_t)(now - task.deadline) < 0)
+            {
+                continue;
+            }
+
+            uint32_t lateness = now - task.deadline;
+            if (lateness > SCHEDULER_OVERRUN_SLACK_MS)
+            {
+                task.overruns++;
+            }
+            if (lateness > task.maxLateness)
+            {
+                task.maxLateness = lateness;
+            }
+
+            // Re-arm before the callback so it can cancel or restart itself
+            if (task.period)
+            {
+                task.deadline += task.period;
+                if ((int32_t)(now - task.deadline) >= 0)
+                {
+                    task.deadline = now + task.period; // Skip missed periods instead of bursting
+                }
+            }
+            else
+            {
+                task.active = false;
+            }
+
+            task.runs++;
+            task.callback(task.context);
+        }
+    }
+
+    // Earliest deadline among the active tasks; false if none is active
+    bool nextDeadline(uint32_t &deadline) const
+    {
+        bool found = false;
+        for (uint8_t i = 0; i < taskCount; i++)
+        {
+            const Task &task = tasks[i];
+            if (task.active && (!found || (int32_t)(task.deadline - deadline) < 0))
+            {
+                deadline = task.deadline;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    uint16_t getOverruns(int8_t id) const
+    {
+        return tasks[id].overruns;
+    }
+
+    void printStats(Print &out) const
+    {
+        for (uint8_t i = 0; i < taskCount; i++)
+        {
+            const Task &task = tasks[i];
+            out.print(task.name);
+            out.print(F(": runs="));
+            out.print(task.runs);
+            out.print(F(" overruns="));
+            out.print(task.overruns);
+            out.print(F(" maxLate="));
+            out.println(task.maxLateness);
+        }
+    }
+};
+
+#endif
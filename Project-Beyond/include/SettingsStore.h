@@ -0,0 +1,68 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <Arduino.h>
+
+#define SETTINGS_EEPROM_BASE 0
+#define SETTINGS_SLOT_COUNT 32          // Ring of records the writes are spread over
+#define SETTINGS_COMMIT_DELAY_MS 5000UL // Quiet time before a change is written
+
+struct Settings
+{
+    uint8_t wakeupTime;
+    uint8_t redLightTime;
+    uint8_t musicIndex;
+};
+
+// One EEPROM slot. The newest record is the valid one with the highest
+// sequence number (compared with wrap-around).
+struct SettingsRecord
+{
+    uint16_t sequence;
+    Settings settings;
+    uint8_t crc;
+};
+
+// Wear-leveled settings persistence. Changes are coalesced until they have
+// been stable for SETTINGS_COMMIT_DELAY_MS and then written to the slot
+// after the newest one, one byte per poll() so the loop never waits on the
+// EEPROM. A write cut short by a reset fails its CRC and the previous
+// record stays in effect.
+class SettingsStore
+{
+private:
+    Settings committed;
+    Settings pending;
+    bool dirty;
+    uint32_t changedAt;
+    uint16_t sequence;
+    uint8_t nextSlot;
+    uint8_t writeOffset; // Byte of the record being written; 0 when idle
+    SettingsRecord outgoing;
+
+public:
+    SettingsStore() : committed(), pending(), dirty(false), changedAt(0), sequence(0), nextSlot(0), writeOffset(0) {}
+
+    // Scans every slot once and restores the newest valid record. Returns
+    // false, leaving settings untouched, if there is none.
+    bool load(Settings &settings);
+
+    // Records a change; it is written once nothing changes for a while
+    void update(const Settings &settings, uint32_t now);
+
+    // Advances a pending commit by at most one EEPROM byte
+    void poll(uint32_t now);
+
+    // True while a change is waiting to be written or being written
+    bool isBusy() const
+    {
+        return dirty || writeOffset;
+    }
+
+    uint16_t getSequence() const
+    {
+        return sequence;
+    }
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <Arduino.h>
+
+// Keeps the compiler from moving slot accesses across the index update
+#define SPSC_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// Lock-free single-producer/single-consumer ring buffer. The producer (an
+// ISR) only writes head and the consumer only writes tail; both indices are
+// single bytes, so reads and writes of them are atomic on AVR. Size must be
+// a power of two no larger than 128.
+template <typename T, uint8_t Size>
+class SpscQueue
+{
+private:
+    T items[Size];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint16_t overflows;
+
+public:
+    SpscQueue() : head(0), tail(0), overflows(0) {}
+
+    // Producer side. Drops the item and counts an overflow when full.
+    bool push(const T &item)
+    {
+        uint8_t h = head;
+        if ((uint8_t)(h - tail) >= Size)
+        {
+            overflows++;
+            return false;
+        }
+        items[h & (Size - 1)] = item;
+        SPSC_BARRIER();
+        head = h + 1; // Publish only after the slot is written
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T &item)
+    {
+        uint8_t t = tail;
+        if (t == head)
+        {
+            return false;
+        }
+        item = items[t & (Size - 1)];
+        SPSC_BARRIER();
+        tail = t + 1;
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return head == tail;
+    }
+
+    // Free slots, as seen by the producer
+    uint8_t space() const
+    {
+        return Size - (uint8_t)(head - tail);
+    }
+
+    uint16_t getOverflows() const
+    {
+        return overflows;
+    }
+};
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef STRIP_RENDERER_H
+#define STRIP_RENDERER_H
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+
+// Retained-mode front end for one strip. The strip's own pixel buffer holds
+// the desired frame; writes that change a pixel mark the frame dirty, and
+// takeFrame() hands it to the caller to send only if something changed
+// since the last show(). A requested frame that turns out identical is
+// counted as skipped. Length is the strip's pixel count, a constant so the
+// fill loops can unroll.
+template <uint16_t Length>
+class StripRenderer
+{
+private:
+    Adafruit_NeoPixel &strip;
+    bool dirty;
+    bool pending;
+    uint16_t shows;
+    uint16_t skipped;
+    uint16_t aborted; // Strip's aborted-show count when last checked
+    uint16_t faded[3]; // Last fade16() levels
+    bool fadedValid;   // false once pixels were written any other way
+
+    void fillPixels(uint32_t color, uint16_t count)
+    {
+        for (uint16_t i = 0; i < Length; i++)
+        {
+            setPixel(i, i < count ? color : 0);
+        }
+    }
+
+    void setLevel(uint8_t level)
+    {
+        if (strip.getBrightness() != level)
+        {
+            strip.setBrightness(level);
+            dirty = true;
+        }
+    }
+
+public:
+    StripRenderer(Adafruit_NeoPixel &target) : strip(target), dirty(false), pending(false), shows(0), skipped(0), aborted(0), fadedValid(false) {}
+
+    void setPixel(uint16_t n, uint32_t color)
+    {
+        if (strip.getPixelColor(n) != color)
+        {
+            strip.setPixelColor(n, color);
+            dirty = true;
+        }
+        fadedValid = false;
+    }
+
+    // Lights the first count pixels with color and clears the rest
+    void fill(uint32_t color, uint16_t count)
+    {
+        setLevel(255);
+        fillPixels(color, count);
+        pending = true;
+    }
+
+    void fill(uint32_t color)
+    {
+        fill(color, Length);
+    }
+
+    // Fills the strip with Q8.8 levels at full brightness. Meant for strips
+    // with a dither buffer, which show the levels between 8-bit steps, so
+    // a fade can move a fraction of a step on every frame.
+    void fade16(uint16_t r, uint16_t g, uint16_t b)
+    {
+        setLevel(255);
+        if (!fadedValid || faded[0] != r || faded[1] != g || faded[2] != b)
+        {
+            for (uint16_t i = 0; i < Length; i++)
+            {
+                strip.setPixelColor16(i, r, g, b);
+            }
+            faded[0] = r;
+            faded[1] = g;
+            faded[2] = b;
+            fadedValid = true;
+            dirty = true;
+        }
+        pending = true;
+    }
+
+    // Takes the requested frame, if any: true if it differs from what is
+    // shown and the caller must now send it, for example with showGroup()
+    bool takeFrame()
+    {
+        if (strip.getAbortedShows() != aborted)
+        {
+            aborted = strip.getAbortedShows();
+            dirty = true; // The last show() was cut short, so send it again
+            pending = true;
+        }
+        if (!pending)
+        {
+            return false;
+        }
+        pending = false;
+
+        // A dithering strip only shows its in-between levels as a stream
+        // of frames, so it is resent even when nothing changed
+        if (!dirty && !strip.isDithering())
+        {
+            skipped++;
+            return false;
+        }
+        dirty = false;
+        shows++;
+        return true;
+    }
+
+    uint16_t getShows() const
+    {
+        return shows;
+    }
+
+    uint16_t getSkipped() const
+    {
+        return skipped;
+    }
+};
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <Arduino.h>
+
+#define TIMELINE_CHANNELS 4          // Red, green, blue, volume
+#define TIMELINE_PROGRESS_END 0x10000UL // Progress of 1.0 in Q0.16
+
+// Shape of the segment from a keyframe to the next one
+enum TimelineCurve
+{
+    TIMELINE_LINEAR,
+    TIMELINE_EASE_IN, // Quadratic, slow start
+    TIMELINE_EASE_OUT // Quadratic, slow finish
+};
+
+// One point of a light/sound profile, stored in PROGMEM. time is in ticks
+// from the start of the profile and must not decrease. curve is a
+// TimelineCurve for the segment that starts here; unused on the last one.
+struct Keyframe
+{
+    uint16_t time;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t volume;
+    uint8_t curve;
+};
+
+// A PROGMEM keyframe sequence
+struct TimelineProfile
+{
+    const Keyframe *frames;
+    uint8_t count;
+};
+
+// Plays a keyframe sequence straight from flash. Each segment's per-tick
+// Q8.8 deltas are computed once when it starts, so a linear tick is one add
+// per channel; an eased tick advances a Q0.16 progress and costs a squaring
+// and one multiply per channel. RAM use does not depend on the number of
+// keyframes or ticks.
+class Timeline
+{
+private:
+    const Keyframe *frames;
+    uint8_t count;
+    uint8_t index; // Keyframe at the start of the current segment
+    uint16_t tick;
+    uint16_t segmentEnd;
+    uint16_t level[TIMELINE_CHANNELS]; // Q8.8
+    int32_t delta[TIMELINE_CHANNELS];  // Q8.8 per tick, to the next tick's level
+    uint8_t curve;                     // Of the current segment
+    uint32_t progress;                 // Q0.16 through an eased segment
+    uint32_t increment;                // Q0.16 per tick
+    uint8_t start[TIMELINE_CHANNELS];  // Eased segment's first keyframe
+    int16_t span[TIMELINE_CHANNELS];   // and its distance to the next one
+
+    static uint8_t readChannels(const Keyframe *frame, uint16_t &time, uint8_t *channels)
+    {
+        Keyframe k;
+        memcpy_P(&k, frame, sizeof(k));
+        time = k.time;
+        channels[0] = k.red;
+        channels[1] = k.green;
+        channels[2] = k.blue;
+        channels[3] = k.volume;
+        return k.curve;
+    }
+
+    // Curve applied to progress p, both Q0.16 up to TIMELINE_PROGRESS_END;
+    // halved before squaring so 1.0 squared stays within 32 bits
+    uint32_t shape(uint32_t p) const
+    {
+        switch (curve)
+        {
+        case TIMELINE_EASE_IN:
+            return ((p >> 1) * (p >> 1)) >> 14;
+        case TIMELINE_EASE_OUT:
+        {
+            uint32_t q = TIMELINE_PROGRESS_END - p;
+            return TIMELINE_PROGRESS_END - (((q >> 1) * (q >> 1)) >> 14);
+        }
+        default:
+            return p;
+        }
+    }
+
+    // Q8.8 level of channel c at progress p through an eased segment
+    int32_t eased(uint8_t c, uint32_t p) const
+    {
+        if (p > TIMELINE_PROGRESS_END)
+        {
+            p = TIMELINE_PROGRESS_END;
+        }
+        return ((int32_t)start[c] << 8) + (((int32_t)span[c] * (int32_t)shape(p)) >> 8);
+    }
+
+    void easeTo(uint32_t p)
+    {
+        progress = p;
+        for (uint8_t c = 0; c < TIMELINE_CHANNELS; c++)
+        {
+            level[c] = eased(c, p);
+            delta[c] = eased(c, p + increment) - level[c];
+        }
+    }
+
+    // Snaps to keyframe index and prepares the deltas toward the next one,
+    // skipping zero-length segments
+    void loadSegment()
+    {
+        uint16_t startTime;
+        curve = readChannels(&frames[index], startTime, start);
+        for (uint8_t c = 0; c < TIMELINE_CHANNELS; c++)
+        {
+            level[c] = start[c] << 8;
+            delta[c] = 0;
+        }
+
+        while (index + 1 < count)
+        {
+            uint8_t end[TIMELINE_CHANNELS];
+            uint8_t nextCurve = readChannels(&frames[index + 1], segmentEnd, end);
+            uint16_t ticks = segmentEnd - startTime;
+            if (ticks)
+            {
+                for (uint8_t c = 0; c < TIMELINE_CHANNELS; c++)
+                {
+                    span[c] = end[c] - start[c];
+                    delta[c] = ((int32_t)span[c] << 8) / ticks;
+                }
+                if (curve != TIMELINE_LINEAR)
+                {
+                    increment = (TIMELINE_PROGRESS_END + ticks - 1) / ticks;
+                    easeTo(0);
+                }
+                return;
+            }
+            index++;
+            curve = nextCurve;
+            for (uint8_t c = 0; c < TIMELINE_CHANNELS; c++)
+            {
+                start[c] = end[c];
+                level[c] = end[c] << 8;
+            }
+        }
+    }
+
+    uint8_t channel(uint8_t c) const
+    {
+        return (level[c] + 128) >> 8;
+    }
+
+    // Q8.8 level phase/256 of the way to the next tick
+    uint16_t channel16(uint8_t c, uint8_t phase) const
+    {
+        int32_t value = level[c] + ((delta[c] * phase) >> 8);
+        return constrain(value, 0, 0xFF00);
+    }
+
+public:
+    Timeline() : frames(0), count(0), index(0), tick(0), segmentEnd(0), curve(TIMELINE_LINEAR), progress(0), increment(0) {}
+
+    // profile must already be copied out of PROGMEM; its frames stay there
+    void begin(const TimelineProfile &profile)
+    {
+        frames = profile.frames;
+        count = profile.count;
+        index = 0;
+        tick = 0;
+        loadSegment();
+    }
+
+    bool isDone() const
+    {
+        return index + 1 >= count;
+    }
+
+    void step()
+    {
+        if (isDone())
+        {
+            return;
+        }
+
+        if (++tick >= segmentEnd)
+        {
+            index++;
+            loadSegment(); // Lands exactly on the keyframe, no accumulated rounding
+            return;
+        }
+
+        if (curve != TIMELINE_LINEAR)
+        {
+            easeTo(progress + increment);
+            return;
+        }
+        for (uint8_t c = 0; c < TIMELINE_CHANNELS; c++)
+        {
+            level[c] += delta[c];
+        }
+    }
+
+    uint8_t red() const { return channel(0); }
+    uint8_t green() const { return channel(1); }
+    uint8_t blue() const { return channel(2); }
+    uint8_t volume() const { return channel(3); }
+
+    // Colors between ticks, in Q8.8, for strips that dither below 8-bit steps
+    uint16_t red16(uint8_t phase) const { return channel16(0, phase); }
+    uint16_t green16(uint8_t phase) const { return channel16(1, phase); }
+    uint16_t blue16(uint8_t phase) const { return channel16(2, phase); }
+};
+
+#endif
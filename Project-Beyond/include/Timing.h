@@ -0,0 +1,104 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <Arduino.h>
+
+// Opt-in stage timing. Build with -D TIMING_ENABLED to record micros()
+// durations into per-stage histograms; without it TIME_STAGE() expands to
+// nothing and none of this is compiled in.
+
+enum TimingStage
+{
+    STAGE_UPDATE,
+    STAGE_MODE_SWITCH,
+    STAGE_KNOB,
+    STAGE_PRESSURE_BUTTON,
+    STAGE_SHOW_STRIPS,
+    STAGE_CONSOLE,
+    STAGE_COUNT
+};
+
+#ifdef TIMING_ENABLED
+
+#define TIMING_BUCKETS 16 // Bucket i holds durations in [2^i, 2^(i+1)) us
+
+// Fixed-size log2 histogram; recording is a shift loop and an increment
+class LatencyHistogram
+{
+private:
+    uint16_t counts[TIMING_BUCKETS];
+    uint32_t samples;
+    uint16_t minimum;
+    uint16_t maximum;
+
+public:
+    LatencyHistogram() : samples(0), minimum(0xFFFF), maximum(0)
+    {
+        memset(counts, 0, sizeof(counts));
+    }
+
+    void record(uint32_t us)
+    {
+        uint16_t clamped = us > 0xFFFF ? 0xFFFF : us;
+        uint8_t bucket = 0;
+        while ((clamped >> bucket) > 1 && bucket < TIMING_BUCKETS - 1)
+        {
+            bucket++;
+        }
+        if (counts[bucket] < 0xFFFF)
+        {
+            counts[bucket]++;
+        }
+        samples++;
+        minimum = min(minimum, clamped);
+        maximum = max(maximum, clamped);
+    }
+
+    // Upper edge of the bucket holding the pct-th percentile, capped at max
+    uint16_t percentile(uint8_t pct) const
+    {
+        uint32_t target = (samples * pct + 99) / 100;
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < TIMING_BUCKETS; i++)
+        {
+            seen += counts[i];
+            if (seen >= target)
+            {
+                uint32_t edge = (2UL << i) - 1;
+                return edge < maximum ? edge : maximum;
+            }
+        }
+        return maximum;
+    }
+
+    uint32_t getSamples() const { return samples; }
+    uint16_t getMin() const { return samples ? minimum : 0; }
+    uint16_t getMax() const { return maximum; }
+};
+
+void timingRecord(uint8_t stage, uint32_t us);
+void timingReport(Print &out);
+
+// Records the lifetime of the enclosing scope under a stage
+class TimingScope
+{
+private:
+    uint8_t stage;
+    uint32_t start;
+
+public:
+    TimingScope(uint8_t timedStage) : stage(timedStage), start(micros()) {}
+    ~TimingScope() { timingRecord(stage, micros() - start); }
+};
+
+#define TIMING_CONCAT_(a, b) a##b
+#define TIMING_CONCAT(a, b) TIMING_CONCAT_(a, b)
+#define TIME_STAGE(stage) TimingScope TIMING_CONCAT(timingScope, __LINE__)(stage)
+
+#else
+
+#define TIME_STAGE(stage)
+
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef WALL_CLOCK_H
+#define WALL_CLOCK_H
+
+#include <Arduino.h>
+#include "RtcSource.h"
+
+// Factory trim for boards without an RTC: how many ppm the resonator runs
+// slow (negative if fast). Override with -D CLOCK_TRIM_PPM=... in build_flags.
+#ifndef CLOCK_TRIM_PPM
+#define CLOCK_TRIM_PPM 0
+#endif
+
+#define CLOCK_TRIM_LIMIT_PPM 20000      // Resonators are within 0.5%; a larger estimate is a bad reading and is dropped
+#define CLOCK_DISCIPLINE_MS 600000UL    // How often the RTC is consulted
+#define CLOCK_REFERENCE_SPAN_MS 86400000UL // Trim is measured over at most a day of ticks
+#define CLOCK_CHUNK_MS 60000UL          // Elapsed ticks are folded in at most this many at a time
+
+// Wall time kept from millis() ticks. Each advance() applies the trim with
+// an error accumulator, so the corrected time stays exact to the ppm over
+// any interval. With an RTC attached, discipline() steps the clock to it
+// and re-estimates the trim from the ticks counted since the first sync.
+class WallClock
+{
+private:
+    RtcSource *rtc;
+    uint32_t lastTick;        // millis() at the last advance
+    uint32_t seconds;         // RTC seconds once synced, otherwise seconds since boot
+    uint16_t milliseconds;
+    int32_t driftResidual;    // Correction not yet applied, in millionths of a ms
+    int16_t trimPpm;
+    bool synced;
+    uint32_t rtcReference;    // RTC seconds at the start of the trim measurement
+    uint32_t ticksSinceReference;
+
+public:
+    WallClock() : rtc(0), lastTick(0), seconds(0), milliseconds(0), driftResidual(0), trimPpm(CLOCK_TRIM_PPM), synced(false), rtcReference(0), ticksSinceReference(0) {}
+
+    void begin(uint32_t now, RtcSource *source);
+
+    // Folds the ticks since the last call into the corrected time. Must be
+    // called at least every 24 days so millis() cannot wrap twice.
+    void advance(uint32_t now);
+
+    // Steps to the RTC and updates the trim. Returns false without an RTC.
+    bool discipline(uint32_t now);
+
+    uint32_t now(uint32_t nowTicks)
+    {
+        advance(nowTicks);
+        return seconds;
+    }
+
+    // millis() ticks until the clock reads target, or 0 if it already has
+    uint32_t ticksUntil(uint32_t target, uint32_t nowTicks);
+
+    int16_t getTrim() const
+    {
+        return trimPpm;
+    }
+
+    bool isSynced() const
+    {
+        return synced;
+    }
+};
+
+#endif
@@ -57,6 +57,12 @@
 //#define NRF52_DISABLE_INT
 #endif
 
+#if defined(ARDUINO_ARCH_RP2040)
+// Strip whose frame each DMA channel is sending, for the shared IRQ handler
+static Adafruit_NeoPixel *rp2040DmaOwners[NUM_DMA_CHANNELS];
+static bool rp2040IrqInstalled = false;
+#endif
+
 #if defined(ARDUINO_ARCH_NRF52840)
 #if defined __has_include
 #if __has_include(<pinDefinitions.h>)
@@ -78,7 +84,15 @@
   @return  Adafruit_NeoPixel object. Call the begin() function before use.
 */
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType t)
-    : begun(false), brightness(0), pixels(NULL), endTime(0) {
+    : begun(false), brightness(0), pixels(NULL), endTime(0), levelSum(0),
+      currentLimit(0), limitedShows(0), bufferSize(0), wire(NULL),
+      wireScale(0), wireStale(false), interruptWindow(0), abortedShows(0),
+      deep(NULL), ditherError(NULL), ditherFraction(false), limitCopy(NULL)
+#if defined(NEO_FRONT_BUFFER)
+      ,
+      front(NULL), frontBusy(false)
+#endif
+{
   updateType(t);
   updateLength(n);
   setPin(p);
@@ -94,6 +108,47 @@ Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType t)
 #endif
 }
 
+/*!
+  @brief   NeoPixel constructor for strips whose pixel data lives in
+           storage supplied by the caller (a static or member array), so
+           the heap is never used. See also StaticNeoPixel.
+  @param   n           Number of NeoPixels in strand.
+  @param   p           Arduino pin number which will drive the NeoPixel
+                       data in.
+  @param   t           Pixel type, as for the constructor above.
+  @param   buffer      Pixel storage, at least n * 3 bytes (n * 4 for RGBW
+                       types). Must outlive the object.
+  @param   size        Size of buffer in bytes. A strip that would not fit
+                       is shortened to what does.
+  @return  Adafruit_NeoPixel object. Call the begin() function before use.
+*/
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType t,
+                                     uint8_t *buffer, uint16_t size)
+    : begun(false), brightness(0), pixels(NULL), endTime(0), levelSum(0),
+      currentLimit(0), limitedShows(0), bufferSize(size), wire(NULL),
+      wireScale(0), wireStale(false), interruptWindow(0), abortedShows(0),
+      deep(NULL), ditherError(NULL), ditherFraction(false), limitCopy(NULL)
+#if defined(NEO_FRONT_BUFFER)
+      ,
+      front(NULL), frontBusy(false)
+#endif
+{
+  updateType(t);   // With no pixels yet, so nothing is reallocated
+  pixels = buffer; // updateLength() uses it in place of malloc()
+  updateLength(n);
+  setPin(p);
+#if defined(ARDUINO_ARCH_RP2040)
+  // Find a free SM on one of the PIO's
+  sm = pio_claim_unused_sm(pio, false); // don't panic
+  // Try pio1 if SM not found
+  if (sm < 0) {
+    pio = pio1;
+    sm = pio_claim_unused_sm(pio, true); // panic if no SM is free
+  }
+  init = true;
+#endif
+}
+
 /*!
   @brief   "Empty" NeoPixel constructor when length, pin and/or pixel type
            are not known at compile-time, and must be initialized later with
@@ -110,14 +165,41 @@ Adafruit_NeoPixel::Adafruit_NeoPixel()
       is800KHz(true),
 #endif
       begun(false), numLEDs(0), numBytes(0), pin(-1), brightness(0),
-      pixels(NULL), rOffset(1), gOffset(0), bOffset(2), wOffset(1), endTime(0) {
+      pixels(NULL), rOffset(1), gOffset(0), bOffset(2), wOffset(1), endTime(0),
+      levelSum(0), currentLimit(0), limitedShows(0), bufferSize(0), wire(NULL),
+      wireScale(0), wireStale(false), interruptWindow(0), abortedShows(0),
+      deep(NULL), ditherError(NULL), ditherFraction(false), limitCopy(NULL)
+#if defined(NEO_FRONT_BUFFER)
+      ,
+      front(NULL), frontBusy(false)
+#endif
+{
 }
 
 /*!
   @brief   Deallocate Adafruit_NeoPixel object, set data pin back to INPUT.
 */
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
-  free(pixels);
+  waitShow();
+#if defined(ARDUINO_ARCH_RP2040)
+  if (dmaChannel >= 0) {
+    dma_channel_set_irq0_enabled(dmaChannel, false);
+    dma_channel_abort(dmaChannel);
+    dma_channel_unclaim(dmaChannel);
+    rp2040DmaOwners[dmaChannel] = NULL;
+  }
+  free(dmaWords);
+#endif
+#if defined(NRF52) || defined(NRF52_SERIES)
+#if defined(ARDUINO_NRF52_ADAFRUIT) // use thread-safe free
+  rtos_free(pwmPattern);
+#else
+  free(pwmPattern);
+#endif
+#endif
+  if (!bufferSize)
+    free(pixels);
+  free(limitCopy);
   if (pin >= 0)
     pinMode(pin, INPUT);
 }
@@ -144,10 +226,31 @@ void Adafruit_NeoPixel::begin(void) {
            type).
 */
 void Adafruit_NeoPixel::updateLength(uint16_t n) {
+  uint8_t bytesPerPixel = (wOffset == rOffset) ? 3 : 4;
+  levelSum = 0;
+  wire = NULL; // Output buffer may no longer fit; see setOutputBuffer()
+  deep = NULL; // Same for the dither buffer; see setDitherBuffer()
+  free(limitCopy);
+  limitCopy = NULL;
+#if defined(NEO_FRONT_BUFFER)
+  waitShow();
+  front = NULL; // Same for the front buffer; see setFrontBuffer()
+#endif
+
+  if (bufferSize) {
+    // Caller-provided storage: reuse it, shortening the strip to fit
+    if (n > bufferSize / bytesPerPixel)
+      n = bufferSize / bytesPerPixel;
+    numBytes = n * bytesPerPixel;
+    memset(pixels, 0, numBytes);
+    numLEDs = n;
+    return;
+  }
+
   free(pixels); // Free existing data (if any)
 
   // Allocate new data -- note: ALL PIXELS ARE CLEARED
-  numBytes = n * ((wOffset == rOffset) ? 3 : 4);
+  numBytes = n * bytesPerPixel;
   if ((pixels = (uint8_t *)malloc(numBytes))) {
     memset(pixels, 0, numBytes);
     numLEDs = n;
@@ -201,15 +304,51 @@ void Adafruit_NeoPixel::rp2040Init(uint8_t pin, bool is800KHz)
 
   if (is800KHz)
   {
-    // 800kHz, 8 bit transfers
-    ws2812_program_init(pio, sm, offset, pin, 800000, 8);
+    // 800kHz, 32 bit transfers of 4 packed bytes
+    ws2812_program_init(pio, sm, offset, pin, 800000, 32);
   }
   else
   {
-    // 400kHz, 8 bit transfers
-    ws2812_program_init(pio, sm, offset, pin, 400000, 8);
+    // 400kHz, 32 bit transfers of 4 packed bytes
+    ws2812_program_init(pio, sm, offset, pin, 400000, 32);
+  }
+
+  // A DMA channel paced by the state machine's TX DREQ feeds the FIFO, so
+  // show() returns as soon as the transfer is started. Without a free
+  // channel, rp2040Show() feeds the FIFO itself.
+  dmaChannel = dma_claim_unused_channel(false);
+  if (dmaChannel < 0)
+    return;
+  dma_channel_config c = dma_channel_get_default_config(dmaChannel);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, pio_get_dreq(pio, sm, true));
+  dma_channel_configure(dmaChannel, &c, &pio->txf[sm], NULL, 0, false);
+
+  rp2040DmaOwners[dmaChannel] = this;
+  dma_channel_set_irq0_enabled(dmaChannel, true);
+  if (!rp2040IrqInstalled) {
+    irq_add_shared_handler(DMA_IRQ_0, rp2040DmaIrq,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+    rp2040IrqInstalled = true;
   }
 }
+
+// Ends the busy state of every strip whose transfer has completed
+void Adafruit_NeoPixel::rp2040DmaIrq(void)
+{
+  for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+    Adafruit_NeoPixel *strip = rp2040DmaOwners[ch];
+    if (strip && dma_channel_get_irq0_status(ch)) {
+      dma_channel_acknowledge_irq0(ch);
+      strip->endTime = micros();
+      strip->dmaBusy = false;
+    }
+  }
+}
+
 // Not a user API
 void  Adafruit_NeoPixel::rp2040Show(uint8_t pin, uint8_t *pixels, uint32_t numBytes, bool is800KHz)
 {
@@ -220,9 +359,27 @@ void  Adafruit_NeoPixel::rp2040Show(uint8_t pin, uint8_t *pixels, uint32_t numBy
     this->init = false;
   }
 
-  while(numBytes--)
-    // Bits for transmission must be shifted to top 8 bits
-    pio_sm_put_blocking(pio, sm, ((uint32_t)*pixels++)<< 24);
+  uint32_t words = rp2040PackedWords(numBytes);
+  if (dmaChannel >= 0 && words > dmaWordCount) {
+    free(dmaWords);
+    dmaWords = (uint32_t *)malloc(words * sizeof(uint32_t));
+    dmaWordCount = dmaWords ? words : 0;
+  }
+
+  if (dmaChannel < 0 || !dmaWords) {
+    for (uint32_t w = 0; w < words; w++)
+      pio_sm_put_blocking(pio, sm, rp2040PackWord(pixels, numBytes, w));
+    dmaTail = 0;
+    return;
+  }
+
+  // DMA reads a packed copy, so the caller may change pixels right away.
+  // Once DMA is done, up to a full FIFO (8 words) plus the output register
+  // are still to be shifted out, at 40 us per word (80 us at 400 KHz).
+  rp2040PackWords(pixels, numBytes, dmaWords);
+  dmaTail = ((words < 9) ? words : 9) * (is800KHz ? 40 : 80);
+  dmaBusy = true;
+  dma_channel_transfer_from_buffer_now(dmaChannel, dmaWords, words);
 }
 #elif defined(ARDUINO_ARCH_CH32)
 
@@ -389,12 +546,23 @@ extern "C" IRAM_ATTR void espShow(uint16_t pin, uint8_t *pixels,
 #elif defined(ESP32)
 extern "C" void espShow(uint16_t pin, uint8_t *pixels, uint32_t numBytes,
                         uint8_t type);
+extern "C" bool espShowAsync(uint8_t pin, uint8_t *pixels, uint32_t numBytes,
+                             bool is800KHz);
+extern "C" bool espShowBusy(uint8_t pin);
 #endif // ESP8266
 
 #if defined(K210)
 #define KENDRYTE_K210 1
 #endif
 
+#if defined(NEOPIXEL_HOST)
+extern "C" void neoPixelHostShow(int16_t pin, const uint8_t *pixels,
+                                 uint32_t offset, uint32_t numBytes);
+extern "C" void neoPixelHostShowAsync(int16_t pin, const uint8_t *pixels,
+                                      uint32_t numBytes);
+extern "C" bool neoPixelHostShowBusy(int16_t pin);
+#endif
+
 #if defined(KENDRYTE_K210)
 extern "C" void k210Show(uint8_t pin, uint8_t *pixels, uint32_t numBytes,
                          boolean is800KHz);
@@ -408,7 +576,11 @@ extern "C" void k210Show(uint8_t pin, uint8_t *pixels, uint32_t numBytes,
            function is called (about 30 microseconds per RGB pixel, 40 for
            RGBW pixels). There's no easy fix for this, but a few
            specialized alternative or companion libraries exist that use
-           very device-specific peripherals to work around it.
+           very device-specific peripherals to work around it. On AVR,
+           setInterruptWindow() bounds how long they stay disabled. On
+           RP2040 (DMA) and nRF52 (PWM), the frame is sent in the
+           background and show() returns once it starts; canShow() stays
+           false until it is done and latched.
 */
 void Adafruit_NeoPixel::show(void) {
 
@@ -423,6 +595,27 @@ void Adafruit_NeoPixel::show(void) {
   // rather than stalling for the latch.
   while (!canShow())
     ;
+
+  // Over the current limit, a scaled copy of the frame is sent instead so
+  // the caller's pixel data stays intact. The copy is swapped in for
+  // 'pixels' until the end of this function. With an output buffer the
+  // limit is already applied there; otherwise the copy is allocated on the
+  // first limited frame, and if that fails the frame is not sent.
+  uint8_t *frame = pixels;
+  uint16_t scale;
+  pixels = outputPixels(scale);
+  if (scale < 256) {
+    if (!limitCopy)
+      limitCopy = (uint8_t *)malloc(numBytes);
+    if (!limitCopy) {
+      pixels = frame;
+      return;
+    }
+    for (uint16_t i = 0; i < numBytes; i++) {
+      limitCopy[i] = (pixels[i] * scale) >> 8;
+    }
+    pixels = limitCopy;
+  }
     // endTime is a private member (rather than global var) so that multiple
     // instances on different pins can be quickly issued in succession (each
     // instance doesn't delay the next).
@@ -446,8 +639,15 @@ void Adafruit_NeoPixel::show(void) {
 #if defined(__AVR__)
   // AVR MCUs -- ATmega & ATtiny (no XMEGA) ---------------------------------
 
-  volatile uint16_t i = numBytes; // Loop counter
-  volatile uint8_t *ptr = pixels, // Pointer to next byte
+  // With an interrupt window set, the frame goes out in chunks of whole
+  // pixels that each fit in the window, and pending interrupts are let in
+  // between chunks while the line idles low. Without one, the single chunk
+  // is the whole frame, as before.
+  uint16_t sent = 0, chunk = chunkBytes();
+  for (;;) { // Each chunk
+  uint16_t count = (numBytes - sent < chunk) ? (numBytes - sent) : chunk;
+  volatile uint16_t i = count;          // Loop counter
+  volatile uint8_t *ptr = &pixels[sent], // Pointer to next byte
       b = *ptr++,                 // Current byte value
       hi,                         // PORT w/output bit set high
       lo;                         // PORT w/output bit set low
@@ -1823,6 +2023,15 @@ void Adafruit_NeoPixel::show(void) {
 #error "CPU SPEED NOT SUPPORTED"
 #endif // end F_CPU ifdefs on __AVR__
 
+  sent += count;
+  if (sent >= numBytes)
+    break;
+  if (!resumeChunk()) {
+    abortedShows++; // The strip may have latched part of the frame
+    break;
+  }
+  } // Each chunk
+
   // END AVR ----------------------------------------------------------------
 
 #elif defined(__arm__)
@@ -2168,15 +2377,13 @@ void Adafruit_NeoPixel::show(void) {
   // memory used in bytes corresponds to the following formula:
   //              totalMem = numBytes*8*2+(2*2)
   // The two additional bytes at the end are needed to reset the
-  // sequence.
+  // sequence. The pattern is allocated once per strip (along with a copy
+  // of the bytes it encodes) and kept, and only bytes that changed since
+  // the previous frame are encoded again.
   //
   // If there is not enough memory, we will fall back to cycle counter
   // using DWT
-  uint32_t pattern_size =
-      numBytes * 8 * sizeof(uint16_t) + 2 * sizeof(uint16_t);
-  uint16_t *pixels_pattern = NULL;
-
-  NRF_PWM_Type *pwm = NULL;
+  NRF_PWM_Type *device = NULL;
 
   // Try to find a free PWM device, which is not enabled
   // and has no connected pins
@@ -2190,59 +2397,71 @@ void Adafruit_NeoPixel::show(void) {
 #endif
   };
 
-  for (unsigned int device = 0; device < (sizeof(PWM) / sizeof(PWM[0]));
-       device++) {
-    if ((PWM[device]->ENABLE == 0) &&
-        (PWM[device]->PSEL.OUT[0] & PWM_PSEL_OUT_CONNECT_Msk) &&
-        (PWM[device]->PSEL.OUT[1] & PWM_PSEL_OUT_CONNECT_Msk) &&
-        (PWM[device]->PSEL.OUT[2] & PWM_PSEL_OUT_CONNECT_Msk) &&
-        (PWM[device]->PSEL.OUT[3] & PWM_PSEL_OUT_CONNECT_Msk)) {
-      pwm = PWM[device];
+  for (unsigned int d = 0; d < (sizeof(PWM) / sizeof(PWM[0])); d++) {
+    if ((PWM[d]->ENABLE == 0) &&
+        (PWM[d]->PSEL.OUT[0] & PWM_PSEL_OUT_CONNECT_Msk) &&
+        (PWM[d]->PSEL.OUT[1] & PWM_PSEL_OUT_CONNECT_Msk) &&
+        (PWM[d]->PSEL.OUT[2] & PWM_PSEL_OUT_CONNECT_Msk) &&
+        (PWM[d]->PSEL.OUT[3] & PWM_PSEL_OUT_CONNECT_Msk)) {
+      device = PWM[d];
       break;
     }
   }
 
-  // only malloc if there is PWM device available
-  if (pwm != NULL) {
+  // Only allocate if there is a PWM device available, and only if the
+  // strip outgrew the pattern it already has
+  if ((device != NULL) && (numBytes > pwmBytes)) {
+    uint32_t size = numBytes * 8 * sizeof(uint16_t) + 2 * sizeof(uint16_t) +
+                    numBytes;
 #if defined(ARDUINO_NRF52_ADAFRUIT) // use thread-safe malloc
-    pixels_pattern = (uint16_t *)rtos_malloc(pattern_size);
+    rtos_free(pwmPattern);
+    pwmPattern = (uint16_t *)rtos_malloc(size);
 #else
-    pixels_pattern = (uint16_t *)malloc(pattern_size);
+    free(pwmPattern);
+    pwmPattern = (uint16_t *)malloc(size);
 #endif
+    pwmBytes = pwmPattern ? numBytes : 0;
+    pwmEncodedBytes = 0; // Encode everything
   }
 
   // Use the identified device to choose the implementation
   // If a PWM device is available use DMA
-  if ((pixels_pattern != NULL) && (pwm != NULL)) {
-    uint16_t pos = 0; // bit position
+  if ((device != NULL) && (pwmBytes >= numBytes)) {
+    uint8_t *encoded = (uint8_t *)&pwmPattern[pwmBytes * 8 + 2];
+    uint16_t t0h = MAGIC_T0H, t1h = MAGIC_T1H;
+#if defined(NEO_KHZ400)
+    if (!is800KHz) {
+      t0h = MAGIC_T0H_400KHz;
+      t1h = MAGIC_T1H_400KHz;
+    }
+#endif
+    if ((numBytes != pwmEncodedBytes) || (is800KHz != pwm800KHz)) {
+      pwmEncodedBytes = 0; // Length or speed changed: encode everything
+      pwm800KHz = is800KHz;
+    }
 
     for (uint16_t n = 0; n < numBytes; n++) {
       uint8_t pix = pixels[n];
+      if (pwmEncodedBytes && (encoded[n] == pix))
+        continue; // Pattern already holds this byte
+      encoded[n] = pix;
 
+      uint16_t *pattern = &pwmPattern[n * 8];
       for (uint8_t mask = 0x80; mask > 0; mask >>= 1) {
-#if defined(NEO_KHZ400)
-        if (!is800KHz) {
-          pixels_pattern[pos] =
-              (pix & mask) ? MAGIC_T1H_400KHz : MAGIC_T0H_400KHz;
-        } else
-#endif
-        {
-          pixels_pattern[pos] = (pix & mask) ? MAGIC_T1H : MAGIC_T0H;
-        }
-
-        pos++;
+        *pattern++ = (pix & mask) ? t1h : t0h;
       }
     }
+    pwmEncodedBytes = numBytes;
 
     // Zero padding to indicate the end of que sequence
-    pixels_pattern[pos++] = 0 | (0x8000); // Seq end
-    pixels_pattern[pos++] = 0 | (0x8000); // Seq end
+    pwmPattern[numBytes * 8] = 0 | (0x8000);     // Seq end
+    pwmPattern[numBytes * 8 + 1] = 0 | (0x8000); // Seq end
 
     // Set the wave mode to count UP
-    pwm->MODE = (PWM_MODE_UPDOWN_Up << PWM_MODE_UPDOWN_Pos);
+    device->MODE = (PWM_MODE_UPDOWN_Up << PWM_MODE_UPDOWN_Pos);
 
     // Set the PWM to use the 16MHz clock
-    pwm->PRESCALER =
+    device->PRESCALER =
         (PWM_PRESCALER_PRESCALER_DIV_1 << PWM_PRESCALER_PRESCALER_Pos);
 
     // Setting of the maximum count
@@ -2250,77 +2469,50 @@ void Adafruit_NeoPixel::show(void) {
     // in case someone wants to do more fine-tuning of the timing.
 #if defined(NEO_KHZ400)
     if (!is800KHz) {
-      pwm->COUNTERTOP = (CTOPVAL_400KHz << PWM_COUNTERTOP_COUNTERTOP_Pos);
+      device->COUNTERTOP = (CTOPVAL_400KHz << PWM_COUNTERTOP_COUNTERTOP_Pos);
     } else
 #endif
     {
-      pwm->COUNTERTOP = (CTOPVAL << PWM_COUNTERTOP_COUNTERTOP_Pos);
+      device->COUNTERTOP = (CTOPVAL << PWM_COUNTERTOP_COUNTERTOP_Pos);
     }
 
     // Disable loops, we want the sequence to repeat only once
-    pwm->LOOP = (PWM_LOOP_CNT_Disabled << PWM_LOOP_CNT_Pos);
+    device->LOOP = (PWM_LOOP_CNT_Disabled << PWM_LOOP_CNT_Pos);
 
     // On the "Common" setting the PWM uses the same pattern for the
     // for supported sequences. The pattern is stored on half-word
     // of 16bits
-    pwm->DECODER = (PWM_DECODER_LOAD_Common << PWM_DECODER_LOAD_Pos) |
-                   (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
+    device->DECODER = (PWM_DECODER_LOAD_Common << PWM_DECODER_LOAD_Pos) |
+                      (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
 
     // Pointer to the memory storing the patter
-    pwm->SEQ[0].PTR = (uint32_t)(pixels_pattern) << PWM_SEQ_PTR_PTR_Pos;
+    device->SEQ[0].PTR = (uint32_t)(pwmPattern) << PWM_SEQ_PTR_PTR_Pos;
 
     // Calculation of the number of steps loaded from memory.
-    pwm->SEQ[0].CNT = (pattern_size / sizeof(uint16_t)) << PWM_SEQ_CNT_CNT_Pos;
+    device->SEQ[0].CNT = (numBytes * 8 + 2) << PWM_SEQ_CNT_CNT_Pos;
 
     // The following settings are ignored with the current config.
-    pwm->SEQ[0].REFRESH = 0;
-    pwm->SEQ[0].ENDDELAY = 0;
-
-    // The Neopixel implementation is a blocking algorithm. DMA
-    // allows for non-blocking operation. To "simulate" a blocking
-    // operation we enable the interruption for the end of sequence
-    // and block the execution thread until the event flag is set by
-    // the peripheral.
-    //    pwm->INTEN |= (PWM_INTEN_SEQEND0_Enabled<<PWM_INTEN_SEQEND0_Pos);
+    device->SEQ[0].REFRESH = 0;
+    device->SEQ[0].ENDDELAY = 0;
 
 // PSEL must be configured before enabling PWM
 #if defined(ARDUINO_ARCH_NRF52840)
-    pwm->PSEL.OUT[0] = g_APinDescription[pin].name;
+    device->PSEL.OUT[0] = g_APinDescription[pin].name;
 #else
-    pwm->PSEL.OUT[0] = g_ADigitalPinMap[pin];
+    device->PSEL.OUT[0] = g_ADigitalPinMap[pin];
 #endif
 
     // Enable the PWM
-    pwm->ENABLE = 1;
+    device->ENABLE = 1;
 
     // After all of this and many hours of reading the documentation
     // we are ready to start the sequence...
-    pwm->EVENTS_SEQEND[0] = 0;
-    pwm->TASKS_SEQSTART[0] = 1;
-
-    // But we have to wait for the flag to be set.
-    while (!pwm->EVENTS_SEQEND[0]) {
-#if defined(ARDUINO_NRF52_ADAFRUIT) || defined(ARDUINO_ARCH_NRF52840)
-      yield();
-#endif
-    }
-
-    // Before leave we clear the flag for the event.
-    pwm->EVENTS_SEQEND[0] = 0;
+    device->EVENTS_SEQEND[0] = 0;
+    device->TASKS_SEQSTART[0] = 1;
 
-    // We need to disable the device and disconnect
-    // all the outputs before leave or the device will not
-    // be selected on the next call.
-    // TODO: Check if disabling the device causes performance issues.
-    pwm->ENABLE = 0;
-
-    pwm->PSEL.OUT[0] = 0xFFFFFFFFUL;
-
-#if defined(ARDUINO_NRF52_ADAFRUIT) // use thread-safe free
-    rtos_free(pixels_pattern);
-#else
-    free(pixels_pattern);
-#endif
+    // ...and return while it runs. The device stays enabled and owned by
+    // this strip until canShow() sees EVENTS_SEQEND and releases it.
+    pwm = device;
   } // End of DMA implementation
   // ---------------------------------------------------------------------
   else {
@@ -3265,6 +3457,21 @@ if(is800KHz) {
 
 #elif defined(ARDUINO_ARCH_CH32)
   ch32Show(gpioPort, gpioPin, pixels, numBytes, is800KHz);
+#elif defined(NEOPIXEL_HOST)
+  // Native simulation build: hand the frame to the host HAL for capture,
+  // in the same chunks as AVR so the interrupt window can be tested
+  uint16_t sent = 0, chunk = chunkBytes();
+  for (;;) {
+    uint16_t count = (numBytes - sent < chunk) ? (numBytes - sent) : chunk;
+    neoPixelHostShow(pin, pixels, sent, count);
+    sent += count;
+    if (sent >= numBytes)
+      break;
+    if (!resumeChunk()) {
+      abortedShows++;
+      break;
+    }
+  }
 #else
 #error Architecture not supported
 #endif
@@ -3276,8 +3483,428 @@ if(is800KHz) {
 #endif
 
   endTime = micros(); // Save EOD time for latch on next call
+  pixels = frame;
+}
+
+/*!
+  @brief   Start sending the frame and return without waiting for it, so
+           the next frame can be drawn into the pixel buffer meanwhile. The
+           frame goes out from a separate front buffer (the backend's own
+           copy on RP2040 and nRF52, the one given to setFrontBuffer() on
+           ESP32), so the pixel buffer keeps the current frame and can be
+           changed at once. Waits for the previous frame first. Where the
+           backend cannot send in the background, or no front buffer is
+           set, this is a plain show().
+*/
+void Adafruit_NeoPixel::showAsync(void) {
+#if defined(NEO_FRONT_BUFFER)
+  if (!front || !pixels) {
+    show();
+    return;
+  }
+  while (!canShow())
+    ;
+
+  // The front buffer gets the frame as it goes out: output-time brightness
+  // and the current limit applied
+  uint16_t scale;
+  uint8_t *out = outputPixels(scale);
+  if (scale < 256) {
+    for (uint16_t i = 0; i < numBytes; i++) {
+      front[i] = (out[i] * scale) >> 8;
+    }
+  } else {
+    memcpy(front, out, numBytes);
+  }
+
+#if defined(ESP32)
+  frontBusy = espShowAsync(pin, front, numBytes, is800KHz);
+  if (!frontBusy)
+    espShow(pin, front, numBytes, is800KHz); // No background send here
+#else
+  neoPixelHostShowAsync(pin, front, numBytes);
+  frontBusy = true;
+#endif
+  endTime = micros(); // Restarted by isShowing() once the frame is out
+#else
+  show(); // RP2040 and nRF52 return early anyway; the rest block
+#endif
+}
+
+/*!
+  @brief   Check whether a frame started by show() or showAsync() is still
+           being sent. Unlike canShow(), this ignores the latch time.
+  @return  true while the backend is still sending.
+*/
+bool Adafruit_NeoPixel::isShowing(void) {
+#if defined(ARDUINO_ARCH_RP2040)
+  return dmaBusy;
+#elif defined(NRF52) || defined(NRF52_SERIES)
+  return !nrf52Idle();
+#elif defined(NEO_FRONT_BUFFER)
+  if (frontBusy) {
+#if defined(ESP32)
+    frontBusy = espShowBusy(pin);
+#else
+    frontBusy = neoPixelHostShowBusy(pin);
+#endif
+    if (!frontBusy)
+      endTime = micros(); // Latch time starts now
+  }
+  return frontBusy;
+#else
+  return false;
+#endif
+}
+
+/*!
+  @brief   Block until the frame being sent, if any, is out.
+*/
+void Adafruit_NeoPixel::waitShow(void) {
+  while (isShowing())
+    ;
+}
+
+/*!
+  @brief   Give showAsync() a front buffer to send from on backends that
+           need one (ESP32, and the host build). RP2040 and nRF52 send from
+           a copy of their own and other MCUs send synchronously, so there
+           the buffer is not used. updateLength() drops it again.
+  @param   buffer  Storage for the frame being sent, at least numBytes long
+                   and outliving the object, or NULL to make showAsync()
+                   a plain show().
+  @param   size    Size of buffer in bytes.
+  @return  true on success, false if the buffer is too small.
+*/
+bool Adafruit_NeoPixel::setFrontBuffer(uint8_t *buffer, uint16_t size) {
+  if (buffer && size < numBytes)
+    return false;
+#if defined(NEO_FRONT_BUFFER)
+  waitShow();
+  front = buffer;
+#endif
+  return true;
+}
+
+#if defined(NRF52) || defined(NRF52_SERIES)
+/*!
+  @brief   Check whether the PWM sequence started by the last show() has
+           ended, and if so release the PWM device and note the end time.
+  @return  true if no frame is being sent.
+*/
+bool Adafruit_NeoPixel::nrf52Idle(void) {
+  if (!pwm)
+    return true;
+  if (!pwm->EVENTS_SEQEND[0])
+    return false;
+
+  // We need to disable the device and disconnect
+  // all the outputs or the device will not
+  // be selected on the next call.
+  pwm->EVENTS_SEQEND[0] = 0;
+  pwm->ENABLE = 0;
+  pwm->PSEL.OUT[0] = 0xFFFFFFFFUL;
+  pwm = NULL;
+  endTime = micros();
+  return true;
+}
+#endif
+
+/*!
+  @brief   Pixel data show() sends: the output buffer, rebuilt if needed,
+           when brightness is applied at output time, otherwise 'pixels'.
+  @param   scale  Set to the current-limit factor still to be applied to
+                  the returned data, out of 256.
+  @return  Pointer to numBytes of pixel data.
+*/
+uint8_t *Adafruit_NeoPixel::outputPixels(uint16_t &scale) {
+  scale = limitScale();
+  if (scale < 256)
+    limitedShows++;
+  if (!wire)
+    return pixels;
+
+  // Output-time brightness: brightness and the limit are applied in one
+  // pass, and only when the frame or either factor has changed
+  if (brightness)
+    scale = (scale * brightness) >> 8;
+  if (deep) {
+    ditherFrame(scale); // Every frame, as the carried error moves on
+  } else if (wireStale || scale != wireScale) {
+    for (uint16_t i = 0; i < numBytes; i++) {
+      wire[i] = (pixels[i] * scale) >> 8;
+    }
+    wireScale = scale;
+    wireStale = false;
+  }
+  scale = 256;
+  return wire;
 }
 
+/*!
+  @brief   Build the output buffer from the Q8.8 working frame. Each byte
+           adds the error its last frame left unsent, sends the integer
+           part and carries the fraction to the next frame, so over
+           successive frames every channel averages its exact level.
+  @param   scale  Brightness and current-limit factor, out of 256, applied
+                  to the 16-bit values before they are rounded.
+*/
+void Adafruit_NeoPixel::ditherFrame(uint16_t scale) {
+  uint8_t fraction = 0;
+  for (uint16_t i = 0; i < numBytes; i++) {
+    uint16_t level = deep[i];
+    if (scale < 256)
+      level = ((uint32_t)level * scale) >> 8;
+    fraction |= (uint8_t)level;
+    uint16_t sum = level + ditherError[i];
+    if (sum < level) { // Past 0xFFFF: full on, nothing left to carry
+      wire[i] = 255;
+      ditherError[i] = 0;
+    } else {
+      wire[i] = sum >> 8;
+      ditherError[i] = (uint8_t)sum;
+    }
+  }
+  ditherFraction = (fraction != 0);
+}
+
+/*!
+  @brief   Copy one pixel just set through an 8-bit setter into the
+           working frame, as whole Q8.8 levels.
+  @param   p  The pixel's bytes in 'pixels'.
+*/
+void Adafruit_NeoPixel::storeDeep(const uint8_t *p) {
+  uint16_t i = p - pixels;
+  uint8_t bytesPerPixel = (wOffset == rOffset) ? 3 : 4;
+  for (uint8_t k = 0; k < bytesPerPixel; k++) {
+    deep[i + k] = p[k] << 8;
+  }
+}
+
+/*!
+  @brief   Transmit several strips at once. On 16 MHz AVR, 800 KHz strips
+           whose pins share one PORT are interleaved in a single timed
+           pass, one bit of every strip per 1.25 us cycle, so the refresh
+           takes as long as the longest strip instead of the sum of all of
+           them, and only one latch wait is paid. Anything else (pins on
+           different ports, 400 KHz strips, other MCUs) falls back to
+           calling showAsync() on each strip in turn. An interleaved pass keeps
+           to the smallest interrupt window set on any of the strips.
+  @param   strips  Strips to send; at most 8 are interleaved.
+  @param   count   Number of entries in strips.
+*/
+void Adafruit_NeoPixel::showGroup(Adafruit_NeoPixel *const strips[],
+                                  uint8_t count) {
+#if defined(__AVR__) && (F_CPU >= 15400000UL) && (F_CPU <= 19000000L)
+  bool parallel = (count > 1) && (count <= 8);
+  for (uint8_t s = 0; parallel && (s < count); s++) {
+    const Adafruit_NeoPixel *strip = strips[s];
+    parallel = strip->pixels && (strip->pin >= 0) &&
+               (strip->port == strips[0]->port);
+#if defined(NEO_KHZ400)
+    parallel = parallel && strip->is800KHz;
+#endif
+  }
+  if (parallel) {
+    showParallel(strips, count);
+    return;
+  }
+#endif
+  for (uint8_t s = 0; s < count; s++)
+    strips[s]->showAsync(); // Overlaps where the backend can
+}
+
+#if defined(__AVR__) || defined(NEOPIXEL_HOST)
+
+/*!
+  @brief   Bytes show() may send in one interrupts-off stretch: whole pixels
+           fitting in the interrupt window (at least one), or the whole
+           frame if no window is set.
+  @return  Chunk size in bytes.
+*/
+uint16_t Adafruit_NeoPixel::chunkBytes(void) const {
+  if (!interruptWindow)
+    return numBytes;
+  uint8_t bytesPerPixel = (wOffset == rOffset) ? 3 : 4;
+  uint16_t pixelTime = bytesPerPixel * 10; // us per pixel at 800 KHz
+#if defined(NEO_KHZ400)
+  if (!is800KHz)
+    pixelTime *= 2;
+#endif
+  uint16_t n = interruptWindow / pixelTime;
+  return (n ? n : 1) * bytesPerPixel;
+}
+
+/*!
+  @brief   Let pending interrupts run between two chunks of a frame, with
+           the data line idling low, and disable them again.
+  @return  true if that took no longer than NEO_RESUME_LIMIT_US, so the
+           strip has not latched and the frame can continue.
+*/
+bool Adafruit_NeoPixel::resumeChunk(void) {
+  uint32_t paused = micros();
+  interrupts();
+#if defined(__AVR__)
+  // An instruction always runs between interrupts; give a few of them a turn
+  asm volatile("nop\n\tnop\n\tnop\n\tnop");
+#endif
+  noInterrupts();
+  return (micros() - paused) <= NEO_RESUME_LIMIT_US;
+}
+
+#endif
+
+/*!
+  @brief   Bound how long show() keeps interrupts disabled. The frame is
+           then sent in chunks of whole pixels, each taking at most this
+           long (but always at least one pixel), with interrupts enabled
+           briefly between chunks, so serial receive, millis() and the like
+           keep working during long frames. If the interrupts that run
+           between chunks take longer than NEO_RESUME_LIMIT_US, the strip
+           may latch a partial frame; show() then stops there and counts it
+           in getAbortedShows(), and the frame should simply be sent again.
+           Only AVR (and the host build, for testing) honors the window;
+           elsewhere it is ignored.
+  @param   us  Interrupts-off window in microseconds, or 0 (the default)
+               for the whole frame at once.
+*/
+void Adafruit_NeoPixel::setInterruptWindow(uint16_t us) {
+  interruptWindow = us;
+}
+
+#if defined(__AVR__) && (F_CPU >= 15400000UL) && (F_CPU <= 19000000L)
+
+// One bit of every strip in the group, 20 clocks like the single-strip
+// 800 KHz code: all pins high, strips whose bit is 0 low at T=5, the rest
+// low at T=13. [plane] holds a 1 for each strip whose bit is 1.
+#define NEO_PARALLEL_BIT                                                       \
+  "st   %a[port], %[hi]"                                                       \
+  "\n\t" /* 2    PORT = hi          (T =  2) */                                \
+  "ld   __tmp_reg__, %a[plane]+"                                               \
+  "\n\t" /* 2    tmp = *plane++     (T =  4) */                                \
+  "or   __tmp_reg__, %[lo]"                                                    \
+  "\n\t" /* 1    tmp |= lo          (T =  5) */                                \
+  "st   %a[port], __tmp_reg__"                                                 \
+  "\n\t" /* 2    PORT = tmp         (T =  7) */                                \
+  "rjmp .+0"                                                                   \
+  "\n\t" /* 2    nop nop            (T =  9) */                                \
+  "rjmp .+0"                                                                   \
+  "\n\t" /* 2    nop nop            (T = 11) */                                \
+  "rjmp .+0"                                                                   \
+  "\n\t" /* 2    nop nop            (T = 13) */                                \
+  "st   %a[port], %[lo]"                                                       \
+  "\n\t" /* 2    PORT = lo          (T = 15) */                                \
+  "rjmp .+0"                                                                   \
+  "\n\t" /* 2    nop nop            (T = 17) */                                \
+  "rjmp .+0"                                                                   \
+  "\n\t" /* 2    nop nop            (T = 19) */                                \
+  "nop"                                                                        \
+  "\n\t" /* 1    nop                (T = 20) */
+
+// Interrupts-off clocks per byte slot of an interleaved pass, for fitting
+// chunks into the interrupt window: the eight 20-clock bits plus clearing
+// the planes and loop overhead, then transposing each strip's byte (length
+// check, load, current-limit multiply, eight shift-test-or steps). Both
+// are estimates with some margin for avr-gcc -Os; two strips come to
+// about 24 us a byte, not the 10 us of the bits alone.
+#define NEO_PARALLEL_SLOT_CLOCKS 200
+#define NEO_PARALLEL_STRIP_CLOCKS 90
+
+/*!
+  @brief   Interleaved transmit for showGroup(); all strips share a PORT.
+  @param   strips  Strips to send, 2 to 8.
+  @param   count   Number of entries in strips.
+*/
+void Adafruit_NeoPixel::showParallel(Adafruit_NeoPixel *const strips[],
+                                     uint8_t count) {
+  uint8_t *data[8], masks[8], group = 0;
+  uint16_t scales[8], lengths[8], longest = 0, window = 0;
+
+  for (uint8_t s = 0; s < count; s++) {
+    Adafruit_NeoPixel *strip = strips[s];
+    while (!strip->canShow())
+      ;
+    data[s] = strip->outputPixels(scales[s]);
+    masks[s] = strip->pinMask;
+    lengths[s] = strip->numBytes;
+    if (lengths[s] > longest)
+      longest = lengths[s];
+    group |= masks[s];
+    if (strip->interruptWindow &&
+        (!window || strip->interruptWindow < window))
+      window = strip->interruptWindow;
+  }
+  // The tightest interrupt window in the group, in byte slots including
+  // the transposition, at least one
+  uint16_t chunk = longest;
+  if (window) {
+    uint32_t clocks = (uint32_t)window * (F_CPU / 1000000UL);
+    chunk = clocks / (NEO_PARALLEL_SLOT_CLOCKS +
+                      (uint16_t)count * NEO_PARALLEL_STRIP_CLOCKS);
+    if (!chunk)
+      chunk = 1;
+  }
+
+  volatile uint8_t *port = strips[0]->port;
+  uint8_t planes[8], *plane, hi, lo;
+
+  noInterrupts(); // Need 100% focus on instruction timing
+
+  lo = *port & ~group;
+  for (uint16_t i = 0, left = chunk; i < longest; i++, left--) {
+    if (!left) {
+      if (!resumeChunk()) {
+        for (uint8_t s = 0; s < count; s++)
+          strips[s]->abortedShows++;
+        break;
+      }
+      lo = *port & ~group; // Interrupts may have changed other pins
+      left = chunk;
+    }
+    // Transpose byte i of every strip into bit planes, MSB first. This
+    // runs with all pins low, so it only stretches the gap between bytes
+    // (about NEO_PARALLEL_STRIP_CLOCKS per strip, well under the latch
+    // time), but it counts against the interrupt window. Strips that have
+    // run out of data are left low.
+    uint8_t active = 0;
+    for (uint8_t k = 0; k < 8; k++)
+      planes[k] = 0;
+    for (uint8_t s = 0; s < count; s++) {
+      if (i >= lengths[s])
+        continue;
+      uint8_t b = data[s][i];
+      if (scales[s] < 256)
+        b = (b * scales[s]) >> 8;
+      active |= masks[s];
+      for (uint8_t k = 0; k < 8; k++, b <<= 1) {
+        if (b & 0x80)
+          planes[k] |= masks[s];
+      }
+    }
+    hi = lo | active;
+    plane = planes;
+
+    asm volatile(NEO_PARALLEL_BIT NEO_PARALLEL_BIT NEO_PARALLEL_BIT
+                     NEO_PARALLEL_BIT NEO_PARALLEL_BIT NEO_PARALLEL_BIT
+                         NEO_PARALLEL_BIT NEO_PARALLEL_BIT
+                 : [plane] "+e"(plane)
+                 : [port] "e"(port), [hi] "r"(hi), [lo] "r"(lo)
+                 : "memory");
+  }
+
+  interrupts();
+
+  uint32_t now = micros(); // Save EOD time for latch on next call
+  for (uint8_t s = 0; s < count; s++)
+    strips[s]->endTime = now;
+}
+
+#undef NEO_PARALLEL_BIT
+#undef NEO_PARALLEL_SLOT_CLOCKS
+#undef NEO_PARALLEL_STRIP_CLOCKS
+
+#endif
+
 /*!
   @brief   Set/change the NeoPixel output pin number. Previous pin,
            if any, is set to INPUT and the new pin is set to OUTPUT.
@@ -3322,7 +3949,7 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
                                       uint8_t b) {
 
   if (n < numLEDs) {
-    if (brightness) { // See notes in setBrightness()
+    if (brightness && !wire) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
       b = (b * brightness) >> 8;
@@ -3332,11 +3959,17 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
       p = &pixels[n * 3];     // 3 bytes per pixel
     } else {                  // Is a WRGB-type strip
       p = &pixels[n * 4];     // 4 bytes per pixel
-      p[wOffset] = 0;         // But only R,G,B passed -- set W to 0
     }
-    p[rOffset] = r; // R,G,B always stored
+    levelSum -= pixelLevel(p);
+    if (wOffset != rOffset)
+      p[wOffset] = 0; // But only R,G,B passed -- set W to 0
+    p[rOffset] = r;   // R,G,B always stored
     p[gOffset] = g;
     p[bOffset] = b;
+    levelSum += pixelLevel(p);
+    wireStale = true;
+    if (deep)
+      storeDeep(p);
   }
 }
 
@@ -3354,7 +3987,7 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
                                       uint8_t b, uint8_t w) {
 
   if (n < numLEDs) {
-    if (brightness) { // See notes in setBrightness()
+    if (brightness && !wire) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
       b = (b * brightness) >> 8;
@@ -3365,11 +3998,17 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
       p = &pixels[n * 3];     // 3 bytes per pixel (ignore W)
     } else {                  // Is a WRGB-type strip
       p = &pixels[n * 4];     // 4 bytes per pixel
-      p[wOffset] = w;         // Store W
     }
-    p[rOffset] = r; // Store R,G,B
+    levelSum -= pixelLevel(p);
+    if (wOffset != rOffset)
+      p[wOffset] = w; // Store W
+    p[rOffset] = r;   // Store R,G,B
     p[gOffset] = g;
     p[bOffset] = b;
+    levelSum += pixelLevel(p);
+    wireStale = true;
+    if (deep)
+      storeDeep(p);
   }
 }
 
@@ -3383,21 +4022,27 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
 void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
   if (n < numLEDs) {
     uint8_t *p, r = (uint8_t)(c >> 16), g = (uint8_t)(c >> 8), b = (uint8_t)c;
-    if (brightness) { // See notes in setBrightness()
+    if (brightness && !wire) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
       b = (b * brightness) >> 8;
     }
     if (wOffset == rOffset) {
       p = &pixels[n * 3];
+      levelSum -= pixelLevel(p);
     } else {
       p = &pixels[n * 4];
+      levelSum -= pixelLevel(p);
       uint8_t w = (uint8_t)(c >> 24);
-      p[wOffset] = brightness ? ((w * brightness) >> 8) : w;
+      p[wOffset] = (brightness && !wire) ? ((w * brightness) >> 8) : w;
     }
     p[rOffset] = r;
     p[gOffset] = g;
     p[bOffset] = b;
+    levelSum += pixelLevel(p);
+    wireStale = true;
+    if (deep)
+      storeDeep(p);
   }
 }
 
@@ -3553,7 +4198,7 @@ uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
 
   if (wOffset == rOffset) { // Is RGB-type device
     p = &pixels[n * 3];
-    if (brightness) {
+    if (brightness && !wire) {
       // Stored color was decimated by setBrightness(). Returned value
       // attempts to scale back to an approximation of the original 24-bit
       // value used when setting the pixel color, but there will always be
@@ -3569,7 +4214,7 @@ uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
     }
   } else { // Is RGBW-type device
     p = &pixels[n * 4];
-    if (brightness) { // Return scaled color
+    if (brightness && !wire) { // Return scaled color
       return (((uint32_t)(p[wOffset] << 8) / brightness) << 24) |
              (((uint32_t)(p[rOffset] << 8) / brightness) << 16) |
              (((uint32_t)(p[gOffset] << 8) / brightness) << 8) |
@@ -3595,6 +4240,8 @@ uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
            problem. Smart programs therefore treat the strip as a
            write-only resource, maintaining their own state to render each
            frame of an animation, not relying on read-modify-write.
+           After setOutputBuffer(), brightness is applied at show() time
+           instead and none of this applies.
 */
 void Adafruit_NeoPixel::setBrightness(uint8_t b) {
   // Stored brightness value is different than what's passed.
@@ -3604,6 +4251,13 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
   // (color values are interpreted literally; no scaling), 1 = min
   // brightness (off), 255 = just below max brightness.
   uint8_t newBrightness = b + 1;
+  if (wire) { // Output-time brightness: the frame is left as it is
+    if (newBrightness != brightness) {
+      brightness = newBrightness;
+      wireStale = true;
+    }
+    return;
+  }
   if (newBrightness != brightness) { // Compare against prior value
     // Brightness has changed -- re-scale existing data in RAM,
     // This process is potentially "lossy," especially when increasing
@@ -3624,9 +4278,11 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
       scale = 65535 / oldBrightness;
     else
       scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
+    levelSum = 0;
     for (uint16_t i = 0; i < numBytes; i++) {
-      c = *ptr;
-      *ptr++ = (c * scale) >> 8;
+      c = (*ptr * scale) >> 8;
+      *ptr++ = c;
+      levelSum += c;
     }
     brightness = newBrightness;
   }
@@ -3641,7 +4297,178 @@ uint8_t Adafruit_NeoPixel::getBrightness(void) const { return brightness - 1; }
 /*!
   @brief   Fill the whole NeoPixel strip with 0 / black / off.
 */
-void Adafruit_NeoPixel::clear(void) { memset(pixels, 0, numBytes); }
+void Adafruit_NeoPixel::clear(void) {
+  memset(pixels, 0, numBytes);
+  if (deep)
+    memset(deep, 0, numBytes * sizeof(uint16_t));
+  levelSum = 0;
+  wireStale = true;
+}
+
+/*!
+  @brief   Set a current budget for the strip. Whenever the estimated draw
+           of a frame exceeds it, show() sends that frame scaled down by a
+           single factor so the estimate fits; the pixel data in RAM is not
+           modified. The estimate uses NEO_MA_PER_CHANNEL and
+           NEO_MA_PER_PIXEL_IDLE. The scaled frame is built in the buffer
+           given to setOutputBuffer(), or else in a copy allocated on the
+           heap by the first limited show().
+  @param   milliamps  Budget in milliamps, or 0 to disable limiting.
+*/
+void Adafruit_NeoPixel::setCurrentLimit(uint16_t milliamps) {
+  currentLimit = milliamps;
+}
+
+/*!
+  @brief   Estimated current draw of the pixel data currently in RAM,
+           before any limiting. Kept up to date incrementally by
+           setPixelColor(), fill(), clear() and setBrightness(), so it is
+           cheap to read every frame.
+  @return  Estimate in milliamps (saturates at 65535).
+*/
+uint16_t Adafruit_NeoPixel::getCurrentEstimate(void) const {
+  uint32_t ma = (uint32_t)numLEDs * NEO_MA_PER_PIXEL_IDLE +
+                outputLevel() * NEO_MA_PER_CHANNEL / 255;
+  return (ma > 65535) ? 65535 : ma;
+}
+
+/*!
+  @brief   Recompute the current estimate from scratch. Only needed after
+           writing to the buffer returned by getPixels() directly. With a
+           dither buffer this also reloads it from those 8-bit values.
+*/
+void Adafruit_NeoPixel::updateCurrentEstimate(void) {
+  levelSum = 0;
+  for (uint16_t i = 0; i < numBytes; i++) {
+    levelSum += pixels[i];
+    if (deep)
+      deep[i] = pixels[i] << 8;
+  }
+  wireStale = true;
+}
+
+/*!
+  @brief   Factor show() applies to stay within the current limit.
+  @return  Scale out of 256; 256 means the frame is sent unchanged.
+*/
+uint16_t Adafruit_NeoPixel::limitScale(void) const {
+  uint32_t level = outputLevel();
+  if (!currentLimit || !level)
+    return 256;
+  uint32_t idle = (uint32_t)numLEDs * NEO_MA_PER_PIXEL_IDLE;
+  if (idle >= currentLimit)
+    return 0;
+  // Channel current scaled by 255 so the comparison needs no division
+  uint32_t channels = level * NEO_MA_PER_CHANNEL;
+  uint32_t budget = (currentLimit - idle) * 255UL;
+  if (channels <= budget)
+    return 256;
+  return (budget << 8) / channels;
+}
+
+/*!
+  @brief   Sum of the color bytes as they will be sent, before limiting.
+  @return  levelSum, scaled by brightness if it is applied at output time.
+*/
+uint32_t Adafruit_NeoPixel::outputLevel(void) const {
+  if (wire && brightness)
+    return (levelSum * brightness) >> 8;
+  return levelSum;
+}
+
+/*!
+  @brief   Apply brightness at output time instead of pre-multiplying it
+           into the pixel data. The frame in RAM then stays unscaled, so
+           getPixelColor() returns exactly what was set and setBrightness()
+           is lossless and costs nothing until the next show(), which
+           builds the scaled copy in this buffer only when the frame,
+           brightness or current limit has changed since the last one.
+           Existing pixel data is taken as unscaled, so call this before
+           drawing. updateLength() turns the mode off again.
+  @param   buffer  Storage for the scaled copy, at least numBytes long and
+                   outliving the object, or NULL to go back to
+                   pre-multiplying.
+  @param   size    Size of buffer in bytes.
+  @return  true on success, false if the buffer is too small.
+*/
+bool Adafruit_NeoPixel::setOutputBuffer(uint8_t *buffer, uint16_t size) {
+  if (buffer && size < numBytes)
+    return false;
+  wire = buffer;
+  wireStale = true;
+  if (!buffer)
+    setDitherBuffer(NULL, 0); // Dithering builds its frames in 'wire'
+  return true;
+}
+
+/*!
+  @brief   Keep a 16-bit working copy of the frame and send it through
+           temporal dithering. Channels are then Q8.8 levels, the 8-bit
+           level times 256, set with setPixelColor16(), and brightness and
+           the current limit scale them before rounding. Each show() sends
+           the nearest 8-bit frame and carries the rounding error into the
+           next one, so a level such as 2.5 alternates 2 and 3 and fades
+           run smoothly below the 8-bit steps, as long as show() is called
+           often enough (see isDithering()) that the alternation does not
+           flicker. The 8-bit setters keep working and store whole levels.
+           Needs setOutputBuffer() first, which the dithered frames are
+           built in; existing pixel data is copied in as whole levels.
+           setOutputBuffer(NULL) and updateLength() turn dithering off.
+  @param   buffer  Storage for numBytes levels followed by numBytes bytes
+                   of carried error, outliving the object (see
+                   StaticNeoPixel::ditherWords), or NULL to stop dithering.
+  @param   size    Size of buffer in 16-bit words.
+  @return  true on success, false if there is no output buffer or this
+           one is too small.
+*/
+bool Adafruit_NeoPixel::setDitherBuffer(uint16_t *buffer, uint16_t size) {
+  if (buffer && (!wire || size < numBytes + (numBytes + 1) / 2))
+    return false;
+  deep = buffer;
+  ditherFraction = false;
+  wireStale = true;
+  if (buffer) {
+    ditherError = (uint8_t *)(buffer + numBytes);
+    for (uint16_t i = 0; i < numBytes; i++) {
+      deep[i] = pixels[i] << 8;
+      // Spread starting errors, so channels at the same level don't all
+      // step up on the same frame
+      ditherError[i] = i * 157;
+    }
+  }
+  return true;
+}
+
+/*!
+  @brief   Set a pixel's color in the dither buffer's 16-bit levels. Does
+           nothing unless setDitherBuffer() is in use.
+  @param   n  Pixel index, starting from 0.
+  @param   r  Red level in Q8.8: 0 = off, 0xFF00 = 255 = maximum, with the
+              low byte in 1/256ths of an 8-bit step.
+  @param   g  Green level, likewise.
+  @param   b  Blue level, likewise.
+  @param   w  White level, likewise, ignored if using RGB pixels.
+*/
+void Adafruit_NeoPixel::setPixelColor16(uint16_t n, uint16_t r, uint16_t g,
+                                        uint16_t b, uint16_t w) {
+  if (deep && (n < numLEDs)) {
+    uint8_t bytesPerPixel = (wOffset == rOffset) ? 3 : 4;
+    uint16_t i = n * bytesPerPixel;
+    uint8_t *p = &pixels[i];
+    uint16_t *d = &deep[i];
+    levelSum -= pixelLevel(p);
+    if (wOffset != rOffset)
+      d[wOffset] = w;
+    d[rOffset] = r;
+    d[gOffset] = g;
+    d[bOffset] = b;
+    for (uint8_t k = 0; k < bytesPerPixel; k++) {
+      p[k] = d[k] >> 8; // Whole levels, for getPixelColor() and the estimate
+    }
+    levelSum += pixelLevel(p);
+    wireStale = true;
+  }
+}
 
 // A 32-bit variant of gamma8() that applies the same function
 // to all components of a packed RGB or WRGB value.
@@ -58,7 +58,17 @@
 #include <stdlib.h>
 #include "hardware/pio.h"
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 #include "rp2040_pio.h"
+#include "rp2040_pack.h"
+#endif
+
+// Backends whose showAsync() sends from a separate, caller-provided front
+// buffer (see setFrontBuffer()). RP2040 and nRF52 send from a copy of
+// their own; everything else sends synchronously.
+#if defined(ESP32) || defined(NEOPIXEL_HOST)
+#define NEO_FRONT_BUFFER
 #endif
 
 // The order of primary colors in the NeoPixel data stream can vary among
@@ -143,6 +153,25 @@
 // If only 800 KHz is enabled (as is default on ATtiny), an 8-bit value
 // is sufficient to encode pixel color order, saving some space.
 
+// Current model used by the optional current limiter (setCurrentLimit()).
+// Per-color-channel draw at full brightness and quiescent draw per pixel,
+// in milliamps; the defaults are typical WS2812B figures.
+
+#ifndef NEO_MA_PER_CHANNEL
+#define NEO_MA_PER_CHANNEL 20 ///< mA drawn by one color channel at 255
+#endif
+#ifndef NEO_MA_PER_PIXEL_IDLE
+#define NEO_MA_PER_PIXEL_IDLE 1 ///< mA drawn by a pixel that is off
+#endif
+
+// Longest pause, in microseconds, a chunked show() (setInterruptWindow())
+// may take between chunks. Must stay below the strip's reset (latch) time:
+// 50 us on original WS2812s, 280 us on WS2812B-V5 and similar.
+
+#ifndef NEO_RESUME_LIMIT_US
+#define NEO_RESUME_LIMIT_US 40 ///< Longer pauses abort the frame
+#endif
+
 #ifdef NEO_KHZ400
 typedef uint16_t neoPixelType; ///< 3rd arg to Adafruit_NeoPixel constructor
 #else
@@ -218,11 +247,18 @@ public:
   // Constructor: number of LEDs, pin number, LED type
   Adafruit_NeoPixel(uint16_t n, int16_t pin = 6,
                     neoPixelType type = NEO_GRB + NEO_KHZ800);
+  // Constructor using caller-provided pixel storage instead of the heap
+  Adafruit_NeoPixel(uint16_t n, int16_t pin, neoPixelType type,
+                    uint8_t *buffer, uint16_t size);
   Adafruit_NeoPixel(void);
   ~Adafruit_NeoPixel();
 
   void begin(void);
   void show(void);
+  void showAsync(void);
+  bool isShowing(void);
+  void waitShow(void);
+  bool setFrontBuffer(uint8_t *buffer, uint16_t size);
   void setPin(int16_t p);
   void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
   void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
@@ -232,6 +268,39 @@ public:
   void clear(void);
   void updateLength(uint16_t n);
   void updateType(neoPixelType t);
+  void setCurrentLimit(uint16_t milliamps);
+  uint16_t getCurrentEstimate(void) const;
+  void updateCurrentEstimate(void);
+  /*!
+    @brief   Retrieve the current limit set with setCurrentLimit().
+    @return  Limit in milliamps, 0 if limiting is disabled.
+  */
+  uint16_t getCurrentLimit(void) const { return currentLimit; }
+  /*!
+    @brief   Count of show() calls whose output was scaled down to stay
+             within the current limit.
+    @return  Number of limited frames since the strip was created.
+  */
+  uint16_t getLimitedShows(void) const { return limitedShows; }
+  void setInterruptWindow(uint16_t us);
+  /*!
+    @brief   Count of show() calls cut short because interrupts between
+             chunks ran past NEO_RESUME_LIMIT_US. See setInterruptWindow().
+    @return  Number of aborted frames since the strip was created.
+  */
+  uint16_t getAbortedShows(void) const { return abortedShows; }
+  bool setOutputBuffer(uint8_t *buffer, uint16_t size);
+  bool setDitherBuffer(uint16_t *buffer, uint16_t size);
+  void setPixelColor16(uint16_t n, uint16_t r, uint16_t g, uint16_t b,
+                       uint16_t w = 0);
+  /*!
+    @brief   Whether the last frame sent had levels between two 8-bit
+             steps. Temporal dithering only shows those while show() keeps
+             being called, so such a frame must be refreshed even if
+             nothing in it changes. See setDitherBuffer().
+    @return  true if the strip needs refreshing to hold its levels.
+  */
+  bool isDithering(void) const { return ditherFraction; }
   /*!
     @brief   Check whether a call to show() will start sending data
              immediately or will 'block' for a required interval. NeoPixels
@@ -261,11 +330,28 @@ public:
     // stall for 30+ minutes, or having to document and frequently remind
     // and/or provide tech support explaining an unintuitive need for
     // show() calls at least once an hour.
+#if defined(ARDUINO_ARCH_RP2040)
+    if (dmaBusy)
+      return false; // DMA is still feeding the previous frame to the PIO
+#endif
+#if defined(NRF52) || defined(NRF52_SERIES)
+    if (!nrf52Idle())
+      return false; // PWM is still sending the previous frame
+#endif
+#if defined(NEO_FRONT_BUFFER)
+    if (isShowing())
+      return false; // The front buffer is still going out
+#endif
     uint32_t now = micros();
     if (endTime > now) {
       endTime = now;
     }
+#if defined(ARDUINO_ARCH_RP2040)
+    // endTime is when DMA finished; the PIO FIFO still had dmaTail us to go
+    return (now - endTime) >= 300L + dmaTail;
+#else
     return (now - endTime) >= 300L;
+#endif
   }
   /*!
     @brief   Get a pointer directly to the NeoPixel data buffer in RAM.
@@ -372,11 +458,34 @@ public:
                bool gammify = true);
 
   static neoPixelType str2order(const char *v);
+  static void showGroup(Adafruit_NeoPixel *const strips[], uint8_t count);
 
 private:
 #if defined(ARDUINO_ARCH_RP2040)
   void  rp2040Init(uint8_t pin, bool is800KHz);
   void  rp2040Show(uint8_t pin, uint8_t *pixels, uint32_t numBytes, bool is800KHz);
+  static void rp2040DmaIrq(void);
+#endif
+#if defined(NRF52) || defined(NRF52_SERIES)
+  bool nrf52Idle(void);
+#endif
+  /*!
+    @brief   Sum of the color bytes of one pixel, for the current estimate.
+  */
+  uint16_t pixelLevel(const uint8_t *p) const {
+    return p[0] + p[1] + p[2] + ((wOffset == rOffset) ? 0 : p[3]);
+  }
+  uint16_t limitScale(void) const;
+  uint32_t outputLevel(void) const;
+  uint8_t *outputPixels(uint16_t &scale);
+  void ditherFrame(uint16_t scale);
+  void storeDeep(const uint8_t *p);
+#if defined(__AVR__) || defined(NEOPIXEL_HOST)
+  uint16_t chunkBytes(void) const;
+  static bool resumeChunk(void);
+#endif
+#if defined(__AVR__)
+  static void showParallel(Adafruit_NeoPixel *const strips[], uint8_t count);
 #endif
 
 protected:
@@ -394,6 +503,23 @@ protected:
   uint8_t bOffset;    ///< Index of blue byte
   uint8_t wOffset;    ///< Index of white (==rOffset if no white)
   uint32_t endTime;   ///< Latch timing reference
+  uint32_t levelSum;  ///< Sum of all bytes in 'pixels', kept incrementally
+  uint16_t currentLimit; ///< Current budget in mA, 0 = unlimited
+  uint16_t limitedShows; ///< Frames scaled down by the current limit
+  uint16_t bufferSize;   ///< Caller-provided 'pixels' size, 0 if on the heap
+  uint8_t *wire;      ///< Scaled copy sent by show(), NULL = pre-multiply
+  uint16_t wireScale; ///< Scale 'wire' was last built with, out of 256
+  bool wireStale;     ///< true if 'pixels' changed since 'wire' was built
+  uint16_t interruptWindow; ///< Longest interrupts-off stretch in us, 0 = any
+  uint16_t abortedShows;    ///< Frames dropped after a late resume
+  uint16_t *deep;       ///< Q8.8 working frame, NULL = 8-bit only
+  uint8_t *ditherError; ///< Per-byte error carried to the next frame
+  bool ditherFraction;  ///< true if the last frame had fractional levels
+  uint8_t *limitCopy;   ///< Heap copy of limited frames when 'wire' is NULL
+#if defined(NEO_FRONT_BUFFER)
+  uint8_t *front;  ///< Buffer showAsync() sends from, NULL = show() instead
+  bool frontBusy;  ///< true while the front buffer is being sent
+#endif
 #ifdef __AVR__
   volatile uint8_t *port; ///< Output PORT register
   uint8_t pinMask;        ///< Output PORT bitmask
@@ -406,7 +532,71 @@ protected:
   PIO pio = pio0;
   int sm = 0;
   bool init = true;
+  int dmaChannel = -1;        ///< DMA channel feeding the PIO, -1 if none
+  uint32_t *dmaWords = NULL;  ///< Packed copy of the frame DMA is sending
+  uint32_t dmaWordCount = 0;  ///< Capacity of dmaWords
+  uint16_t dmaTail = 0;       ///< us of data left in the PIO when DMA ends
+  volatile bool dmaBusy = false; ///< true until the DMA IRQ fires
+#endif
+#if defined(NRF52) || defined(NRF52_SERIES)
+  NRF_PWM_Type *pwm = NULL;     ///< PWM device sending a frame, NULL if idle
+  uint16_t *pwmPattern = NULL;  ///< PWM sequence, followed by the bytes it encodes
+  uint16_t pwmBytes = 0;        ///< Pixel bytes pwmPattern has room for
+  uint16_t pwmEncodedBytes = 0; ///< Bytes currently encoded, 0 = none valid
+  bool pwm800KHz = true;        ///< Speed pwmPattern was encoded for
 #endif
 };
 
+/*!
+    @brief  Pixel storage for StaticNeoPixel. A base class listed before
+            Adafruit_NeoPixel, so the array's lifetime has begun by the
+            time the Adafruit_NeoPixel constructor clears it.
+    @tparam N     Number of pixels.
+    @tparam TYPE  Pixel type, as for the Adafruit_NeoPixel constructor.
+*/
+template <uint16_t N, neoPixelType TYPE> class StaticNeoPixelStorage {
+public:
+  /*!
+    @brief   Bytes per pixel for TYPE: 4 if it has a white channel.
+  */
+  static const uint8_t bytesPerPixel =
+      (((TYPE >> 6) & 0b11) == ((TYPE >> 4) & 0b11)) ? 3 : 4;
+  /*!
+    @brief   Size of the pixel buffer, also what setOutputBuffer() needs.
+  */
+  static const uint16_t bufferBytes = N * bytesPerPixel;
+
+protected:
+  uint8_t storage[bufferBytes]; ///< The pixel buffer
+};
+
+/*!
+    @brief  Adafruit_NeoPixel whose pixel buffer is an array sized at
+            compile time, so it never touches the heap and its RAM shows
+            up in .bss (or wherever the object lives) at link time. The
+            full Adafruit_NeoPixel API is available; updateLength() can
+            shrink the strip but not grow it past N.
+    @tparam N     Number of pixels.
+    @tparam TYPE  Pixel type, as for the Adafruit_NeoPixel constructor.
+*/
+template <uint16_t N, neoPixelType TYPE = NEO_GRB + NEO_KHZ800>
+class StaticNeoPixel : public StaticNeoPixelStorage<N, TYPE>,
+                       public Adafruit_NeoPixel {
+public:
+  using StaticNeoPixelStorage<N, TYPE>::bytesPerPixel;
+  using StaticNeoPixelStorage<N, TYPE>::bufferBytes;
+  /*!
+    @brief   Size in 16-bit words of what setDitherBuffer() needs.
+  */
+  static const uint16_t ditherWords = bufferBytes + (bufferBytes + 1) / 2;
+  /*!
+    @brief   StaticNeoPixel constructor.
+    @param   p  Arduino pin number which will drive the NeoPixel data in.
+    @return  StaticNeoPixel object. Call the begin() function before use.
+  */
+  StaticNeoPixel(int16_t p = 6)
+      : StaticNeoPixelStorage<N, TYPE>(),
+        Adafruit_NeoPixel(N, p, TYPE, this->storage, sizeof(this->storage)) {}
+};
+
 #endif // ADAFRUIT_NEOPIXEL_H
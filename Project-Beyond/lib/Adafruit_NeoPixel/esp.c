@@ -17,9 +17,59 @@
  * limitations under the License.
  */
 
-#if defined(ESP32)
+#if defined(ESP32) || defined(NEOPIXEL_HOST)
+
+#include "esp_encoder.h"
 
+#if defined(ESP32)
 #include <Arduino.h>
+#define NEO_ENCODER_ATTR IRAM_ATTR // Called from the RMT interrupt
+#else
+#define NEO_ENCODER_ATTR
+#endif
+
+uint32_t espSymbol(uint32_t highNs, uint32_t lowNs, uint32_t resolutionHz) {
+  uint32_t high = ((uint64_t)highNs * resolutionHz + 500000000) / 1000000000;
+  uint32_t low = ((uint64_t)lowNs * resolutionHz + 500000000) / 1000000000;
+  if (high > 0x7FFF)
+    high = 0x7FFF;
+  if (low > 0x7FFF)
+    low = 0x7FFF;
+  return high | (1UL << 15) | (low << 16);
+}
+
+uint32_t espResetSymbol(uint32_t resetNs, uint32_t resolutionHz) {
+  uint32_t ticks = ((uint64_t)resetNs * resolutionHz + 500000000) / 1000000000;
+  uint32_t first = (ticks + 1) / 2, second = ticks / 2;
+  if (first > 0x7FFF)
+    first = 0x7FFF;
+  if (second > 0x7FFF)
+    second = 0x7FFF;
+  return first | (second << 16); // Both levels low
+}
+
+size_t NEO_ENCODER_ATTR espEncodeSymbols(const uint8_t *pixels,
+                                         size_t numBytes, size_t position,
+                                         uint32_t *symbols, size_t count,
+                                         uint32_t bit0, uint32_t bit1,
+                                         uint32_t reset, bool *done) {
+  size_t total = numBytes * 8, n = 0;
+  while (n < count && position < total) {
+    symbols[n++] =
+        (pixels[position >> 3] & (0x80 >> (position & 7))) ? bit1 : bit0;
+    position++;
+  }
+  if (n < count && position == total) {
+    symbols[n++] = reset;
+    position++;
+  }
+  *done = (position > total);
+  return n;
+}
+
+#endif // ESP32 || NEOPIXEL_HOST
+
+#if defined(ESP32)
 
 #if defined(ESP_IDF_VERSION)
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
@@ -28,11 +78,159 @@
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 #define HAS_ESP_IDF_5
 #endif
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+#define HAS_ESP_IDF_5_3 // Has the RMT simple encoder
 #endif
+#endif
+
+#define WS2812_T0H_NS (400)
+#define WS2812_T0L_NS (850)
+#define WS2812_T1H_NS (800)
+#define WS2812_T1L_NS (450)
+
+#define WS2811_T0H_NS (500)
+#define WS2811_T0L_NS (2000)
+#define WS2811_T1H_NS (1200)
+#define WS2811_T1L_NS (1300)
+
+#define NEO_RMT_RESET_NS (300000) // Latch time, as canShow() allows
+
+#if defined(HAS_ESP_IDF_5_3)
+
+#include "driver/rmt_tx.h"
+#include "driver/rmt_encoder.h"
+
+// Each pin gets an RMT channel on its first show() and keeps it. A simple
+// encoder streams symbols from the pixel buffer into the channel's
+// ping-pong memory from the RMT interrupt as it drains, so neither stack
+// nor heap use grows with the strip length.
+
+#define NEO_RMT_RESOLUTION_HZ 10000000 // 100 ns ticks
+
+// Pins that can hold a channel at once; show() on further pins does nothing
+#ifndef NEO_RMT_STRIPS_MAX
+#define NEO_RMT_STRIPS_MAX 4
+#endif
+
+typedef struct {
+  rmt_channel_handle_t channel; // NULL if the slot is free
+  rmt_encoder_handle_t encoder;
+  uint8_t pin;
+  boolean is800KHz;
+  uint32_t bit0; // Symbols for a 0 and a 1 bit
+  uint32_t bit1;
+  uint32_t reset; // Latch symbol after the last bit
+} neo_rmt_strip_t;
+
+static neo_rmt_strip_t rmt_strips[NEO_RMT_STRIPS_MAX];
+
+static size_t IRAM_ATTR espEncodeCallback(const void *data, size_t data_size,
+                                          size_t symbols_written,
+                                          size_t symbols_free,
+                                          rmt_symbol_word_t *symbols,
+                                          bool *done, void *arg) {
+  const neo_rmt_strip_t *strip = (const neo_rmt_strip_t *)arg;
+  return espEncodeSymbols((const uint8_t *)data, data_size, symbols_written,
+                          (uint32_t *)symbols, symbols_free, strip->bit0,
+                          strip->bit1, strip->reset, done);
+}
+
+static void espSetTiming(neo_rmt_strip_t *strip, boolean is800KHz) {
+  strip->is800KHz = is800KHz;
+  if (is800KHz) {
+    strip->bit0 = espSymbol(WS2812_T0H_NS, WS2812_T0L_NS, NEO_RMT_RESOLUTION_HZ);
+    strip->bit1 = espSymbol(WS2812_T1H_NS, WS2812_T1L_NS, NEO_RMT_RESOLUTION_HZ);
+  } else {
+    strip->bit0 = espSymbol(WS2811_T0H_NS, WS2811_T0L_NS, NEO_RMT_RESOLUTION_HZ);
+    strip->bit1 = espSymbol(WS2811_T1H_NS, WS2811_T1L_NS, NEO_RMT_RESOLUTION_HZ);
+  }
+  strip->reset = espResetSymbol(NEO_RMT_RESET_NS, NEO_RMT_RESOLUTION_HZ);
+}
+
+// The channel for pin, set up on first use; NULL if none could be had
+static neo_rmt_strip_t *espStrip(uint8_t pin, boolean is800KHz) {
+  neo_rmt_strip_t *strip = NULL;
+  for (size_t i = 0; i < NEO_RMT_STRIPS_MAX; i++) {
+    if (rmt_strips[i].channel && rmt_strips[i].pin == pin) {
+      if (rmt_strips[i].is800KHz != is800KHz)
+        espSetTiming(&rmt_strips[i], is800KHz);
+      return &rmt_strips[i];
+    }
+    if (!rmt_strips[i].channel && !strip)
+      strip = &rmt_strips[i];
+  }
+  if (!strip) {
+    log_e("No RMT slot left for pin %d", pin);
+    return NULL;
+  }
+
+  rmt_tx_channel_config_t channel_config = {
+      .gpio_num = pin,
+      .clk_src = RMT_CLK_SRC_DEFAULT,
+      .resolution_hz = NEO_RMT_RESOLUTION_HZ,
+      .mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL,
+      .trans_queue_depth = 1,
+  };
+  if (rmt_new_tx_channel(&channel_config, &strip->channel) != ESP_OK) {
+    log_e("Failed to init RMT TX channel on pin %d", pin);
+    strip->channel = NULL;
+    return NULL;
+  }
 
+  strip->pin = pin;
+  espSetTiming(strip, is800KHz);
+
+  rmt_simple_encoder_config_t encoder_config = {
+      .callback = espEncodeCallback,
+      .arg = strip,
+      .min_chunk_size = 1, // Any free space can take a symbol
+  };
+  if (rmt_new_simple_encoder(&encoder_config, &strip->encoder) != ESP_OK) {
+    log_e("Failed to create RMT encoder for pin %d", pin);
+    rmt_del_channel(strip->channel);
+    strip->channel = NULL;
+    return NULL;
+  }
+  rmt_enable(strip->channel);
+  return strip;
+}
 
+// Starts sending and returns; pixels must stay untouched until
+// espShowBusy() is false. Returns false if pin has no channel.
+bool espShowAsync(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
+  neo_rmt_strip_t *strip = espStrip(pin, is800KHz);
+  if (!strip)
+    return false;
+  if (!numBytes)
+    return true;
+
+  rmt_transmit_config_t transmit_config = {
+      .loop_count = 0,
+  };
+  return rmt_transmit(strip->channel, strip->encoder, pixels, numBytes,
+                      &transmit_config) == ESP_OK;
+}
 
-#ifdef HAS_ESP_IDF_5
+bool espShowBusy(uint8_t pin) {
+  for (size_t i = 0; i < NEO_RMT_STRIPS_MAX; i++) {
+    if (rmt_strips[i].channel && rmt_strips[i].pin == pin)
+      return rmt_tx_wait_all_done(rmt_strips[i].channel, 0) != ESP_OK;
+  }
+  return false;
+}
+
+void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
+  if (!espShowAsync(pin, pixels, numBytes, is800KHz))
+    return;
+  // Wait, as pixels may be rewritten as soon as show() returns
+  for (uint32_t start = millis(); espShowBusy(pin) && millis() - start < 100;)
+    ;
+}
+
+#elif defined(HAS_ESP_IDF_5)
+
+// ESP-IDF 5.0 to 5.2 lack the simple encoder; this builds the whole frame's
+// symbols on the stack (32 bytes per pixel byte) and sets up RMT each time.
 
 void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
   rmt_data_t led_data[numBytes * 8];
@@ -74,16 +272,6 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
 // This code is adapted from the ESP-IDF v3.4 RMT "led_strip" example, altered
 // to work with the Arduino version of the ESP-IDF (3.2)
 
-#define WS2812_T0H_NS (400)
-#define WS2812_T0L_NS (850)
-#define WS2812_T1H_NS (800)
-#define WS2812_T1L_NS (450)
-
-#define WS2811_T0H_NS (500)
-#define WS2811_T0L_NS (2000)
-#define WS2811_T1H_NS (1200)
-#define WS2811_T1L_NS (1300)
-
 static uint32_t t0h_ticks = 0;
 static uint32_t t1h_ticks = 0;
 static uint32_t t0l_ticks = 0;
@@ -218,7 +406,16 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
     gpio_set_direction(pin, GPIO_MODE_OUTPUT);
 }
 
-#endif // ifndef IDF5
+#endif // IDF 5.3, IDF 5, older
+
+#if !defined(HAS_ESP_IDF_5_3)
+// No background sending before IDF 5.3: showAsync() falls back to espShow()
+bool espShowAsync(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
+  return false;
+}
+
+bool espShowBusy(uint8_t pin) { return false; }
+#endif
  
 
 #endif // ifdef(ESP32)
@@ -0,0 +1,38 @@
+// Byte-to-symbol encoding for the ESP32 RMT backend in esp.c. Plain C with
+// no ESP-IDF dependencies, so it also builds on the host (NEOPIXEL_HOST).
+
+#ifndef ESP_ENCODER_H
+#define ESP_ENCODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One RMT symbol word, laid out as rmt_symbol_word_t: duration0 in bits
+// 0-14 at level0 (bit 15, high), duration1 in bits 16-30 at level1 (bit 31,
+// low). Durations are rounded to the nearest tick of resolutionHz.
+uint32_t espSymbol(uint32_t highNs, uint32_t lowNs, uint32_t resolutionHz);
+
+// A symbol that holds the line low for resetNs, split over both halves, so
+// the strip latches the frame before anything else is sent
+uint32_t espResetSymbol(uint32_t resetNs, uint32_t resolutionHz);
+
+// Encodes pixel bits, MSB first, starting at symbol 'position' of the
+// frame, into up to 'count' symbols; the frame is numBytes * 8 bit symbols
+// followed by the reset symbol. Returns the number written and sets *done
+// once the reset symbol has been encoded. Stops mid-byte when 'symbols'
+// fills up, so it can stream into RMT memory of any size.
+size_t espEncodeSymbols(const uint8_t *pixels, size_t numBytes,
+                        size_t position, uint32_t *symbols, size_t count,
+                        uint32_t bit0, uint32_t bit1, uint32_t reset,
+                        bool *done);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ESP_ENCODER_H
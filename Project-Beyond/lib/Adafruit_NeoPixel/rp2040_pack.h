@@ -0,0 +1,39 @@
+// Word packing for the RP2040 DMA backend. The PIO program shifts its
+// output register out MSB first with a 32-bit autopull, so pixel bytes go
+// four to a word, the first in bits 31-24. No Pico SDK dependencies, so it
+// also builds on the host (NEOPIXEL_HOST).
+
+#ifndef RP2040_PACK_H
+#define RP2040_PACK_H
+
+#include <stdint.h>
+
+// Words needed for numBytes of pixel data
+static inline uint32_t rp2040PackedWords(uint32_t numBytes) {
+  return (numBytes + 3) / 4;
+}
+
+// Word 'index' of the packed frame. A short last word is padded with zero
+// bits, which shift out past the end of the strip and are ignored.
+static inline uint32_t rp2040PackWord(const uint8_t *pixels,
+                                      uint32_t numBytes, uint32_t index) {
+  uint32_t word = 0;
+  for (uint32_t i = index * 4; i < index * 4 + 4; i++) {
+    word = (word << 8) | ((i < numBytes) ? pixels[i] : 0);
+  }
+  return word;
+}
+
+// Packs the whole frame into rp2040PackedWords(numBytes) words
+static inline void rp2040PackWords(const uint8_t *pixels, uint32_t numBytes,
+                                   uint32_t *words) {
+  uint32_t full = numBytes / 4;
+  for (uint32_t w = 0; w < full; w++, pixels += 4) {
+    words[w] = ((uint32_t)pixels[0] << 24) | ((uint32_t)pixels[1] << 16) |
+               ((uint32_t)pixels[2] << 8) | pixels[3];
+  }
+  if (numBytes % 4)
+    words[full] = rp2040PackWord(pixels - full * 4, numBytes, full);
+}
+
+#endif // RP2040_PACK_H
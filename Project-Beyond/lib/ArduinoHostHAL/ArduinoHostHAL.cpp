@@ -0,0 +1,575 @@
+#include <stdio.h>
+#include "HostHAL.h"
+#include "SoftwareSerial.h"
+#include "EEPROM.h"
+
+#define HAL_MICROS_PER_CALL 1      // Each micros() call costs a little time so busy-waits progress
+#define HAL_NEOPIXEL_BYTE_US 10    // 8 bits at 800 kHz
+#define HAL_MAX_FRAME_BYTES 1200
+#define HAL_MAX_FRAME_PINS 4
+#define HAL_SERIAL_RX_SIZE 256
+#define HAL_INTERRUPT_COUNT 2
+#define HAL_RTC_EPOCH 1700000000UL // RTC reading at the start of the simulation
+
+static uint64_t nowMicros;
+static int32_t driftPpm;
+static bool rtcPresent = true;
+static bool idleRequested;
+static uint32_t idleDeadline;
+static uint8_t pinModes[NUM_DIGITAL_PINS];
+static int pinLevels[NUM_DIGITAL_PINS];
+static int analogInputs[NUM_DIGITAL_PINS];
+static int analogOutputs[NUM_DIGITAL_PINS];
+
+static bool interruptsEnabled = true;
+static void (*interruptHandlers[HAL_INTERRUPT_COUNT])(void);
+static int interruptModes[HAL_INTERRUPT_COUNT];
+static bool interruptPending[HAL_INTERRUPT_COUNT];
+static bool injectedQueued;
+static uint64_t injectedAt;
+static uint32_t injectedDuration;
+
+struct CapturedFrame
+{
+    int16_t pin;
+    uint32_t numBytes;
+    uint32_t shows;
+    uint8_t data[HAL_MAX_FRAME_BYTES];
+    const uint8_t *sending; // Buffer an asynchronous show is reading, 0 if none
+    uint64_t sentAt;        // When that show finishes
+    uint32_t violations;    // Buffers written to while being sent
+    uint8_t submitted[HAL_MAX_FRAME_BYTES];
+};
+static CapturedFrame frames[HAL_MAX_FRAME_PINS];
+static uint8_t frameCount;
+
+static char serialRx[HAL_SERIAL_RX_SIZE];
+static uint16_t serialRxHead;
+static uint16_t serialRxTail;
+static bool serialMuted;
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+
+// Virtual clock -------------------------------------------------------------
+
+uint64_t halNowMicros()
+{
+    return nowMicros;
+}
+
+void halAdvanceMicros(uint64_t us)
+{
+    nowMicros += us;
+}
+
+void halSetDriftPpm(int32_t ppm)
+{
+    driftPpm = ppm;
+}
+
+// Time as the firmware's oscillator counts it
+static uint64_t localMicros()
+{
+    return nowMicros + (int64_t)nowMicros * driftPpm / 1000000;
+}
+
+bool halRtcRead(uint32_t *seconds)
+{
+    if (!rtcPresent)
+    {
+        return false;
+    }
+    *seconds = HAL_RTC_EPOCH + (uint32_t)(nowMicros / 1000000);
+    return true;
+}
+
+void halSetRtcPresent(bool present)
+{
+    rtcPresent = present;
+}
+
+void halIdleUntil(uint32_t deadline)
+{
+    idleRequested = true;
+    idleDeadline = deadline;
+}
+
+bool halTakeIdle(uint64_t *untilMicros)
+{
+    if (!idleRequested)
+    {
+        return false;
+    }
+    idleRequested = false;
+
+    // Rebuild the full local time from the 32-bit deadline, then convert it
+    // back to true time
+    uint64_t local = localMicros();
+    uint64_t deadline = local / 1000 + (int32_t)(idleDeadline - (uint32_t)(local / 1000));
+    *untilMicros = deadline * 1000 * 1000000 / (1000000 + driftPpm);
+    return true;
+}
+
+unsigned long millis(void)
+{
+    return (unsigned long)(localMicros() / 1000);
+}
+
+unsigned long micros(void)
+{
+    nowMicros += HAL_MICROS_PER_CALL;
+    return (unsigned long)localMicros();
+}
+
+void delay(unsigned long ms)
+{
+    nowMicros += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    nowMicros += us;
+}
+
+void yield(void)
+{
+}
+
+// Pins ------------------------------------------------------------------------
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < NUM_DIGITAL_PINS)
+    {
+        pinModes[pin] = mode;
+        if (mode == INPUT_PULLUP)
+        {
+            pinLevels[pin] = HIGH;
+        }
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin < NUM_DIGITAL_PINS)
+    {
+        pinLevels[pin] = val ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < NUM_DIGITAL_PINS ? pinLevels[pin] : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+    if (pin < A0)
+    {
+        pin += A0; // Channel numbers are accepted too
+    }
+    nowMicros += 110; // A single conversion at the default prescaler
+    return pin < NUM_DIGITAL_PINS ? analogInputs[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int val)
+{
+    if (pin < NUM_DIGITAL_PINS)
+    {
+        analogOutputs[pin] = val;
+    }
+}
+
+void halSetAnalog(uint8_t pin, int value)
+{
+    if (pin < NUM_DIGITAL_PINS)
+    {
+        analogInputs[pin] = value;
+    }
+}
+
+int halGetPinOutput(uint8_t pin)
+{
+    return digitalRead(pin);
+}
+
+int halGetAnalogOutput(uint8_t pin)
+{
+    return pin < NUM_DIGITAL_PINS ? analogOutputs[pin] : 0;
+}
+
+// Interrupts ------------------------------------------------------------------
+
+static void dispatchPending()
+{
+    for (uint8_t i = 0; i < HAL_INTERRUPT_COUNT; i++)
+    {
+        if (interruptPending[i] && interruptHandlers[i])
+        {
+            interruptPending[i] = false;
+            interruptHandlers[i]();
+        }
+    }
+}
+
+void noInterrupts(void)
+{
+    interruptsEnabled = false;
+}
+
+void interrupts(void)
+{
+    interruptsEnabled = true;
+    dispatchPending();
+    if (injectedQueued && nowMicros >= injectedAt)
+    {
+        injectedQueued = false;
+        nowMicros += injectedDuration;
+    }
+}
+
+void halInjectInterrupt(uint32_t delayUs, uint32_t durationUs)
+{
+    injectedQueued = true;
+    injectedAt = nowMicros + delayUs;
+    injectedDuration = durationUs;
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode)
+{
+    if (interruptNum < HAL_INTERRUPT_COUNT)
+    {
+        interruptHandlers[interruptNum] = userFunc;
+        interruptModes[interruptNum] = mode;
+        interruptPending[interruptNum] = false;
+    }
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+    if (interruptNum < HAL_INTERRUPT_COUNT)
+    {
+        interruptHandlers[interruptNum] = 0;
+    }
+}
+
+void halSetPin(uint8_t pin, int level)
+{
+    if (pin >= NUM_DIGITAL_PINS || pinLevels[pin] == level)
+    {
+        return;
+    }
+    pinLevels[pin] = level;
+
+    int irq = digitalPinToInterrupt(pin);
+    if (irq < 0 || !interruptHandlers[irq])
+    {
+        return;
+    }
+    int mode = interruptModes[irq];
+    if (mode == CHANGE || (mode == RISING && level == HIGH) || (mode == FALLING && level == LOW))
+    {
+        interruptPending[irq] = true; // Latched like the hardware flag
+        if (interruptsEnabled)
+        {
+            dispatchPending();
+        }
+    }
+}
+
+// Math --------------------------------------------------------------------------
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+long random(long howbig)
+{
+    return howbig ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig)
+{
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+    srand(seed);
+}
+
+// Print -------------------------------------------------------------------------
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    if (base < 2)
+    {
+        base = 10;
+    }
+    do
+    {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return write(str);
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == DEC && n < 0)
+    {
+        size_t t = print('-');
+        return t + printNumber(-(unsigned long)n, DEC);
+    }
+    return printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return write(buf);
+}
+
+// Serial --------------------------------------------------------------------------
+
+void HardwareSerial::begin(unsigned long)
+{
+}
+
+int HardwareSerial::available()
+{
+    return (uint16_t)(serialRxHead - serialRxTail);
+}
+
+int HardwareSerial::read()
+{
+    if (serialRxHead == serialRxTail)
+    {
+        return -1;
+    }
+    return (uint8_t)serialRx[serialRxTail++ % HAL_SERIAL_RX_SIZE];
+}
+
+int HardwareSerial::peek()
+{
+    if (serialRxHead == serialRxTail)
+    {
+        return -1;
+    }
+    return (uint8_t)serialRx[serialRxTail % HAL_SERIAL_RX_SIZE];
+}
+
+int HardwareSerial::availableForWrite()
+{
+    return 63; // Never full: stdout absorbs everything
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if (!serialMuted)
+    {
+        fputc(c, stdout);
+    }
+    return 1;
+}
+
+void halMuteSerial(bool muted)
+{
+    serialMuted = muted;
+}
+
+void halSerialInput(const char *text)
+{
+    while (*text && (uint16_t)(serialRxHead - serialRxTail) < HAL_SERIAL_RX_SIZE)
+    {
+        serialRx[serialRxHead++ % HAL_SERIAL_RX_SIZE] = *text++;
+    }
+}
+
+// SoftwareSerial ----------------------------------------------------------------------
+
+SoftwareSerial::SoftwareSerial(uint8_t, uint8_t, bool) : rxHead(0), rxTail(0), txCount(0)
+{
+}
+
+void SoftwareSerial::begin(long)
+{
+}
+
+int SoftwareSerial::available()
+{
+    return (uint8_t)(rxHead - rxTail);
+}
+
+int SoftwareSerial::read()
+{
+    if (rxHead == rxTail)
+    {
+        return -1;
+    }
+    return rxBuffer[rxTail++ % HAL_SOFTWARE_SERIAL_RX_SIZE];
+}
+
+int SoftwareSerial::peek()
+{
+    if (rxHead == rxTail)
+    {
+        return -1;
+    }
+    return rxBuffer[rxTail % HAL_SOFTWARE_SERIAL_RX_SIZE];
+}
+
+size_t SoftwareSerial::write(uint8_t c)
+{
+    lastTx[txCount & 15] = c;
+    txCount++;
+    nowMicros += 1042; // One 10-bit frame at 9600 baud, sent with interrupts off
+    return 1;
+}
+
+void SoftwareSerial::inject(uint8_t c)
+{
+    if ((uint8_t)(rxHead - rxTail) < HAL_SOFTWARE_SERIAL_RX_SIZE)
+    {
+        rxBuffer[rxHead++ % HAL_SOFTWARE_SERIAL_RX_SIZE] = c;
+    }
+}
+
+// NeoPixel capture ---------------------------------------------------------------------
+
+static CapturedFrame *findFrame(int16_t pin, bool create)
+{
+    for (uint8_t i = 0; i < frameCount; i++)
+    {
+        if (frames[i].pin == pin)
+        {
+            return &frames[i];
+        }
+    }
+    if (!create || frameCount >= HAL_MAX_FRAME_PINS)
+    {
+        return 0;
+    }
+    CapturedFrame *frame = &frames[frameCount++];
+    frame->pin = pin;
+    return frame;
+}
+
+// Bytes offset to offset + numBytes of a frame, sent with interrupts off.
+// A frame starts at offset 0; bytes past the last chunk sent keep their old
+// values, as on a strip that latched part of a frame.
+extern "C" void neoPixelHostShow(int16_t pin, const uint8_t *pixels, uint32_t offset, uint32_t numBytes)
+{
+    CapturedFrame *frame = findFrame(pin, true);
+    if (frame && offset < HAL_MAX_FRAME_BYTES)
+    {
+        uint32_t end = offset + numBytes < HAL_MAX_FRAME_BYTES ? offset + numBytes : HAL_MAX_FRAME_BYTES;
+        memcpy(frame->data + offset, pixels + offset, end - offset);
+        if (end > frame->numBytes)
+        {
+            frame->numBytes = end;
+        }
+        if (!offset)
+        {
+            frame->shows++;
+        }
+    }
+    nowMicros += (uint64_t)numBytes * HAL_NEOPIXEL_BYTE_US;
+}
+
+// Like neoPixelHostShow(), but the frame is read from pixels only when it
+// finishes, numBytes * HAL_NEOPIXEL_BYTE_US later, without holding up the
+// clock. The buffer belongs to the backend until then; a frame that changed
+// in between is captured as changed and counted as an ownership violation.
+extern "C" void neoPixelHostShowAsync(int16_t pin, const uint8_t *pixels, uint32_t numBytes)
+{
+    CapturedFrame *frame = findFrame(pin, true);
+    if (!frame)
+    {
+        return;
+    }
+    frame->numBytes = numBytes < HAL_MAX_FRAME_BYTES ? numBytes : HAL_MAX_FRAME_BYTES;
+    memcpy(frame->submitted, pixels, frame->numBytes);
+    frame->sending = pixels;
+    frame->sentAt = nowMicros + (uint64_t)numBytes * HAL_NEOPIXEL_BYTE_US;
+}
+
+// Captures an asynchronous frame once its time is up; true if it still isn't
+static bool frameSending(CapturedFrame *frame)
+{
+    if (!frame || !frame->sending)
+    {
+        return false;
+    }
+    if (nowMicros < frame->sentAt)
+    {
+        return true;
+    }
+    if (memcmp(frame->sending, frame->submitted, frame->numBytes) != 0)
+    {
+        frame->violations++;
+    }
+    memcpy(frame->data, frame->sending, frame->numBytes);
+    frame->sending = 0;
+    frame->shows++;
+    return false;
+}
+
+extern "C" bool neoPixelHostShowBusy(int16_t pin)
+{
+    if (frameSending(findFrame(pin, false)))
+    {
+        nowMicros += HAL_MICROS_PER_CALL; // Polling takes time, like micros()
+        return true;
+    }
+    return false;
+}
+
+uint32_t halGetOwnershipViolations(int16_t pin)
+{
+    CapturedFrame *frame = findFrame(pin, false);
+    frameSending(frame); // A finished frame counts even if nobody polled for it
+    return frame ? frame->violations : 0;
+}
+
+const uint8_t *halGetFrame(int16_t pin, uint32_t *numBytes)
+{
+    CapturedFrame *frame = findFrame(pin, false);
+    frameSending(frame);
+    *numBytes = frame ? frame->numBytes : 0;
+    return frame ? frame->data : 0;
+}
+
+uint32_t halGetShowCount(int16_t pin)
+{
+    CapturedFrame *frame = findFrame(pin, false);
+    frameSending(frame);
+    return frame ? frame->shows : 0;
+}
@@ -0,0 +1,59 @@
+#ifndef ARDUINO_HOST_HAL_EEPROM_H
+#define ARDUINO_HOST_HAL_EEPROM_H
+
+#include <Arduino.h>
+
+#define HAL_EEPROM_SIZE 1024 // ATmega328P
+
+// RAM-backed EEPROM, erased (0xFF) at start unless the simulation loads an
+// image with --eeprom
+class EEPROMClass
+{
+public:
+    uint8_t data[HAL_EEPROM_SIZE];
+    uint32_t writes;
+
+    EEPROMClass() : writes(0)
+    {
+        memset(data, 0xFF, sizeof(data));
+    }
+
+    uint8_t read(int address) { return data[address % HAL_EEPROM_SIZE]; }
+    void write(int address, uint8_t value)
+    {
+        data[address % HAL_EEPROM_SIZE] = value;
+        writes++;
+    }
+    void update(int address, uint8_t value)
+    {
+        if (read(address) != value)
+        {
+            write(address, value);
+        }
+    }
+    uint16_t length() { return HAL_EEPROM_SIZE; }
+
+    template <typename T>
+    T &get(int address, T &t)
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            ((uint8_t *)&t)[i] = read(address + i);
+        }
+        return t;
+    }
+
+    template <typename T>
+    const T &put(int address, const T &t)
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            update(address + i, ((const uint8_t *)&t)[i]);
+        }
+        return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
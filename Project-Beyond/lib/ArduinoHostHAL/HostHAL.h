@@ -0,0 +1,56 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <Arduino.h>
+
+// Controls for driving the firmware from a host simulation
+
+// Virtual clock. halNowMicros() is true time; millis() and micros() run
+// fast by the drift set here (slow if negative), as a resonator would.
+uint64_t halNowMicros();
+void halAdvanceMicros(uint64_t us);
+void halSetDriftPpm(int32_t ppm);
+
+// Mock RTC, reading true time in seconds
+bool halRtcRead(uint32_t *seconds);
+void halSetRtcPresent(bool present);
+
+// Lets the firmware report it has nothing to do until a millis() deadline;
+// the simulator takes the request and skips ahead instead of stepping
+void halIdleUntil(uint32_t deadline);
+bool halTakeIdle(uint64_t *untilMicros);
+
+// Queues an interrupt handler that becomes pending delayUs from now and,
+// when interrupts are next enabled after that, holds the CPU for
+// durationUs, as SoftwareSerial's receive handler does for a whole byte
+void halInjectInterrupt(uint32_t delayUs, uint32_t durationUs);
+
+// Sets a digital input level, firing an attached interrupt on a matching
+// edge (deferred while interrupts are disabled)
+void halSetPin(uint8_t pin, int level);
+void halSetAnalog(uint8_t pin, int value);
+int halGetPinOutput(uint8_t pin);
+int halGetAnalogOutput(uint8_t pin);
+
+// Bytes returned by Serial.read()
+void halSerialInput(const char *text);
+
+// Drops Serial output instead of writing it to stdout, for test runners
+// that report there
+void halMuteSerial(bool muted);
+
+// Frames captured at Adafruit_NeoPixel::show(), per data pin. An
+// asynchronous frame is captured once its send time is up, polled or not.
+// An aborted chunked show leaves the rest of the previous frame in place.
+const uint8_t *halGetFrame(int16_t pin, uint32_t *numBytes);
+uint32_t halGetShowCount(int16_t pin);
+
+// Asynchronous shows whose buffer was modified before they finished
+uint32_t halGetOwnershipViolations(int16_t pin);
+
+// Called by the NeoPixel host backend in place of the bit-banged output
+extern "C" void neoPixelHostShow(int16_t pin, const uint8_t *pixels, uint32_t offset, uint32_t numBytes);
+extern "C" void neoPixelHostShowAsync(int16_t pin, const uint8_t *pixels, uint32_t numBytes);
+extern "C" bool neoPixelHostShowBusy(int16_t pin);
+
+#endif
@@ -0,0 +1,231 @@
+// Entry point for the native build: runs setup() and loop() against the
+// virtual clock while replaying scripted input changes.
+//
+//   program [--run-ms N] [--step-us N] [--pin MS:PIN:LEVEL]... [--analog MS:PIN:VALUE]...
+//           [--serial MS:TEXT]... [--eeprom FILE] [--drift-ppm N] [--no-rtc]
+//
+// Without any --pin events the pressure button (D2) is pressed at 1 s and
+// held, which plays one full night cycle. --eeprom loads the EEPROM image
+// from FILE if it exists and writes it back at the end. --drift-ppm makes
+// millis() run fast against the mock RTC; --no-rtc removes the RTC.
+// Event times are true (RTC) time. Whenever the firmware reports it is
+// idle the clock jumps to its deadline or the next event, so hours of
+// darkness take milliseconds. Firmware Serial output goes to stdout; a
+// summary goes to stderr. Each --serial TEXT arrives as one line, newline
+// included. Left out of `pio test` builds, whose test runner has its own
+// main() and drives setup() and loop() itself.
+
+#ifndef PIO_UNIT_TESTING
+
+#include <stdio.h>
+#include <time.h>
+#include "HostHAL.h"
+#include "EEPROM.h"
+
+#define SIM_MAX_EVENTS 64
+#define SIM_DEFAULT_RUN_MS 3700000UL // One night at the default wakeupTime of 1 hour
+#define SIM_DEFAULT_STEP_US 1000UL
+#define SIM_PRESSURE_PIN 2
+#define SIM_NEOPIXEL_PINS 2
+
+void setup(void);
+void loop(void);
+
+enum SimEventKind
+{
+    SIM_PIN,
+    SIM_ANALOG,
+    SIM_SERIAL
+};
+
+struct SimEvent
+{
+    uint64_t atMicros;
+    SimEventKind kind;
+    uint8_t pin;
+    int value;
+    const char *text;
+};
+
+static SimEvent events[SIM_MAX_EVENTS];
+static uint8_t eventCount;
+
+static bool addEvent(const char *spec, SimEventKind kind)
+{
+    unsigned long ms;
+    unsigned pin = 0;
+    int value = 0;
+    int textStart = 0;
+    if (eventCount >= SIM_MAX_EVENTS)
+    {
+        return false;
+    }
+    if (kind == SIM_SERIAL ? sscanf(spec, "%lu:%n", &ms, &textStart) != 1 || !textStart
+                           : sscanf(spec, "%lu:%u:%d", &ms, &pin, &value) != 3)
+    {
+        return false;
+    }
+    SimEvent &event = events[eventCount++];
+    event.atMicros = (uint64_t)ms * 1000;
+    event.kind = kind;
+    event.pin = pin;
+    event.value = value;
+    event.text = spec + textStart;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t runMicros = SIM_DEFAULT_RUN_MS * 1000;
+    uint64_t stepMicros = SIM_DEFAULT_STEP_US;
+    bool scripted = false;
+    const char *eepromFile = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--run-ms") && hasValue)
+        {
+            runMicros = strtoull(argv[++i], 0, 10) * 1000;
+        }
+        else if (!strcmp(argv[i], "--step-us") && hasValue)
+        {
+            stepMicros = strtoull(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "--pin") && hasValue && addEvent(argv[i + 1], SIM_PIN))
+        {
+            i++;
+            scripted = true;
+        }
+        else if (!strcmp(argv[i], "--analog") && hasValue && addEvent(argv[i + 1], SIM_ANALOG))
+        {
+            i++;
+        }
+        else if (!strcmp(argv[i], "--serial") && hasValue && addEvent(argv[i + 1], SIM_SERIAL))
+        {
+            i++;
+        }
+        else if (!strcmp(argv[i], "--eeprom") && hasValue)
+        {
+            eepromFile = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--drift-ppm") && hasValue)
+        {
+            halSetDriftPpm(strtol(argv[++i], 0, 10));
+        }
+        else if (!strcmp(argv[i], "--no-rtc"))
+        {
+            halSetRtcPresent(false);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--run-ms N] [--step-us N] [--pin MS:PIN:LEVEL]... [--analog MS:PIN:VALUE]... [--serial MS:TEXT]... [--eeprom FILE] [--drift-ppm N] [--no-rtc]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!scripted)
+    {
+        addEvent("1000:2:1", SIM_PIN);
+    }
+
+    if (eepromFile)
+    {
+        FILE *image = fopen(eepromFile, "rb");
+        if (image)
+        {
+            fread(EEPROM.data, 1, sizeof(EEPROM.data), image);
+            fclose(image);
+        }
+    }
+
+    clock_t started = clock();
+    uint64_t loops = 0;
+    uint64_t skippedMicros = 0;
+
+    setup();
+    while (halNowMicros() < runMicros)
+    {
+        for (uint8_t i = 0; i < eventCount; i++)
+        {
+            if (events[i].atMicros != UINT64_MAX && events[i].atMicros <= halNowMicros())
+            {
+                switch (events[i].kind)
+                {
+                case SIM_PIN:
+                    halSetPin(events[i].pin, events[i].value);
+                    break;
+                case SIM_ANALOG:
+                    halSetAnalog(events[i].pin, events[i].value);
+                    break;
+                case SIM_SERIAL:
+                    halSerialInput(events[i].text);
+                    halSerialInput("\n");
+                    break;
+                }
+                events[i].atMicros = UINT64_MAX;
+            }
+        }
+
+        uint64_t before = halNowMicros();
+        loop();
+        loops++;
+
+        uint64_t idleUntil;
+        if (halTakeIdle(&idleUntil))
+        {
+            // Skip to the deadline, stopping early for the next event
+            for (uint8_t i = 0; i < eventCount; i++)
+            {
+                if (events[i].atMicros < idleUntil)
+                {
+                    idleUntil = events[i].atMicros;
+                }
+            }
+            if (idleUntil > runMicros)
+            {
+                idleUntil = runMicros;
+            }
+            if (idleUntil > halNowMicros())
+            {
+                skippedMicros += idleUntil - halNowMicros();
+                halAdvanceMicros(idleUntil - halNowMicros());
+            }
+            continue;
+        }
+
+        // A pass that took less virtual time than a step idles for the rest
+        uint64_t spent = halNowMicros() - before;
+        if (spent < stepMicros)
+        {
+            halAdvanceMicros(stepMicros - spent);
+        }
+    }
+    fflush(stdout);
+
+    if (eepromFile)
+    {
+        FILE *image = fopen(eepromFile, "wb");
+        if (image)
+        {
+            fwrite(EEPROM.data, 1, sizeof(EEPROM.data), image);
+            fclose(image);
+        }
+    }
+
+    double wallMs = (double)(clock() - started) * 1000.0 / CLOCKS_PER_SEC;
+    fprintf(stderr, "\nsimulated %.3f s in %.1f ms wall time, %llu loop passes\n",
+            halNowMicros() / 1e6, wallMs, (unsigned long long)loops);
+    fprintf(stderr, "  %.3f s skipped while idle\n", skippedMicros / 1e6);
+    fprintf(stderr, "  %u EEPROM byte writes\n", (unsigned)EEPROM.writes);
+    for (int16_t pin = 0; pin < NUM_DIGITAL_PINS; pin++)
+    {
+        if (halGetShowCount(pin))
+        {
+            fprintf(stderr, "  pin %d: %u show() calls, %u buffer ownership violations\n", pin,
+                    (unsigned)halGetShowCount(pin), (unsigned)halGetOwnershipViolations(pin));
+        }
+    }
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,37 @@
+#ifndef ARDUINO_HOST_HAL_SOFTWARE_SERIAL_H
+#define ARDUINO_HOST_HAL_SOFTWARE_SERIAL_H
+
+#include <Arduino.h>
+
+#define HAL_SOFTWARE_SERIAL_RX_SIZE 64
+
+// Records transmitted bytes; received bytes are queued with inject()
+class SoftwareSerial : public Stream
+{
+private:
+    uint8_t rxBuffer[HAL_SOFTWARE_SERIAL_RX_SIZE];
+    uint8_t rxHead;
+    uint8_t rxTail;
+    uint32_t txCount;
+    uint8_t lastTx[16];
+
+public:
+    SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverseLogic = false);
+    void begin(long speed);
+    bool listen() { return true; }
+    bool isListening() { return true; }
+    void end() {}
+    int available();
+    int read();
+    int peek();
+    void flush() {}
+    size_t write(uint8_t c);
+    using Print::write;
+
+    void inject(uint8_t c);
+    uint32_t getTxCount() const { return txCount; }
+    // Byte transmitted n positions back (0 = most recent)
+    uint8_t getLastTx(uint8_t n) const { return lastTx[(txCount - 1 - n) & 15]; }
+};
+
+#endif
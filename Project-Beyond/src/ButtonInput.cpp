@@ -0,0 +1,106 @@
+#include "ButtonInput.h"
+#include "Power.h"
+
+static SpscQueue<ButtonEvent, BUTTON_QUEUE_SIZE> buttonQueue;
+static uint8_t buttonPins[BUTTON_COUNT];
+
+void ButtonInput::pushEdge(uint8_t button, uint8_t level)
+{
+    ButtonEvent event;
+    event.button = button;
+    event.level = level;
+    event.time = micros();
+    buttonQueue.push(event);
+    powerWake();
+}
+
+void ButtonInput::begin(uint8_t pressurePin, uint8_t modePin, void (*onPressure)(), void (*onMode)())
+{
+    buttonPins[BUTTON_PRESSURE] = pressurePin;
+    buttonPins[BUTTON_MODE] = modePin;
+
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++)
+    {
+        states[i].stable = digitalRead(buttonPins[i]);
+        states[i].raw = states[i].stable;
+        states[i].lastEdge = now;
+        states[i].lastAccept = now;
+    }
+
+    // D2 and D3 are INT0 and INT1 on the Uno
+    attachInterrupt(digitalPinToInterrupt(pressurePin), onPressure, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(modePin), onMode, CHANGE);
+}
+
+bool ButtonInput::accept(uint8_t button, uint8_t level, uint32_t time, ButtonEvent &change)
+{
+    states[button].stable = level;
+    states[button].lastAccept = time;
+    change.button = button;
+    change.level = level;
+    change.time = time;
+    return true;
+}
+
+bool ButtonInput::poll(ButtonEvent &change, uint32_t now)
+{
+    // Bounded so a bouncing contact cannot keep the loop here
+    ButtonEvent event;
+    for (uint8_t n = 0; n < BUTTON_QUEUE_SIZE && buttonQueue.pop(event); n++)
+    {
+        ButtonState &state = states[event.button];
+        state.raw = event.level;
+        state.lastEdge = event.time;
+
+        // The first edge after a quiet period is reported immediately;
+        // bounces that follow within the debounce window are absorbed
+        if (event.level != state.stable && event.time - state.lastAccept >= BUTTON_DEBOUNCE_US)
+        {
+            return accept(event.button, event.level, event.time, change);
+        }
+    }
+
+    // A level that changed during a bounce window and then stayed put is
+    // accepted once the line has been quiet for the debounce interval
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++)
+    {
+        if (states[i].raw != states[i].stable && now - states[i].lastEdge >= BUTTON_DEBOUNCE_US)
+        {
+            return accept(i, states[i].raw, now, change);
+        }
+    }
+    return false;
+}
+
+void ButtonInput::resync()
+{
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++)
+    {
+        uint8_t level = digitalRead(buttonPins[i]);
+        if (level != states[i].raw)
+        {
+            // The queue has one producer at a time only with the ISRs held off
+            noInterrupts();
+            pushEdge(i, level);
+            interrupts();
+        }
+    }
+}
+
+bool ButtonInput::isSettled() const
+{
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++)
+    {
+        if (states[i].raw != states[i].stable)
+        {
+            return false;
+        }
+    }
+    return buttonQueue.isEmpty();
+}
+
+uint16_t ButtonInput::getDropped() const
+{
+    return buttonQueue.getOverflows();
+}
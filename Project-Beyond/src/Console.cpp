@@ -0,0 +1,65 @@
+#include "Console.h"
+
+uint8_t Console::poll(char **argv)
+{
+    for (uint8_t n = 0; n < CONSOLE_BYTES_PER_POLL && stream.available(); n++)
+    {
+        char c = stream.read();
+        if (c != '\n' && c != '\r')
+        {
+            if (length < CONSOLE_LINE_SIZE - 1)
+            {
+                line[length++] = c;
+            }
+            else
+            {
+                overflowed = true;
+            }
+            continue;
+        }
+
+        if (overflowed)
+        {
+            overflowed = false;
+            length = 0;
+            discarded++;
+            continue;
+        }
+
+        line[length] = '\0';
+        length = 0;
+        uint8_t argc = tokenize(argv);
+        if (argc)
+        {
+            return argc; // One command per poll; the rest waits in the stream
+        }
+    }
+    return 0;
+}
+
+uint8_t Console::tokenize(char **argv)
+{
+    uint8_t argc = 0;
+    char *p = line;
+    while (argc < CONSOLE_MAX_ARGS)
+    {
+        while (*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        if (!*p)
+        {
+            break;
+        }
+        argv[argc++] = p;
+        while (*p && *p != ' ' && *p != '\t')
+        {
+            p++;
+        }
+        if (*p)
+        {
+            *p++ = '\0';
+        }
+    }
+    return argc;
+}
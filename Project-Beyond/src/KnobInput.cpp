@@ -0,0 +1,123 @@
+#include "KnobInput.h"
+
+// 12-bit EMA scaled by 2^KNOB_EMA_SHIFT; fits in 16 bits
+static volatile uint16_t knobEma;
+
+static void feedDecimated(uint16_t sample)
+{
+    knobEma += sample - (knobEma >> KNOB_EMA_SHIFT);
+}
+
+#ifdef __AVR__
+
+static uint16_t knobSum;
+static uint8_t knobCount;
+
+ISR(ADC_vect)
+{
+    knobSum += ADC;
+    if (++knobCount == KNOB_OVERSAMPLE)
+    {
+        feedDecimated(knobSum >> 2); // 16 x 10-bit samples -> 12 bits
+        knobSum = 0;
+        knobCount = 0;
+    }
+}
+
+void KnobInput::begin(uint8_t pin)
+{
+    uint8_t channel = pin >= A0 ? pin - A0 : pin;
+
+    // end() leaves the ADC disabled, and analogRead() needs it enabled
+    // and clocked, so restore that first
+    ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+
+    // Seed the filter with a blocking read so the first value is settled
+    knobEma = (uint16_t)(analogRead(pin) << 2) << KNOB_EMA_SHIFT;
+
+    ADMUX = _BV(REFS0) | (channel & 0x07); // AVcc reference
+    ADCSRB = 0;                            // Free-running trigger
+
+    // Prescaler 128 (125 kHz ADC clock), auto-trigger and interrupt enabled
+    ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+}
+
+void KnobInput::end()
+{
+    ADCSRA = 0;
+}
+
+uint16_t KnobInput::read() const
+{
+    noInterrupts();
+    uint16_t ema = knobEma;
+    interrupts();
+    return (ema >> KNOB_EMA_SHIFT) >> 2;
+}
+
+#else
+
+// No free-running ADC: filter synchronous reads instead, feeding the EMA as
+// many decimated samples as the AVR pipeline would have produced since the
+// previous read
+#define KNOB_MAX_CATCH_UP 64
+
+static uint8_t knobPin;
+static uint32_t knobLastRead;
+
+void KnobInput::begin(uint8_t pin)
+{
+    knobPin = pin;
+    knobLastRead = millis();
+    knobEma = (uint16_t)(analogRead(pin) << 2) << KNOB_EMA_SHIFT;
+}
+
+void KnobInput::end()
+{
+}
+
+uint16_t KnobInput::read() const
+{
+    uint32_t now = millis();
+    uint32_t samples = (now - knobLastRead) * 3 / 5; // 125 kHz / 13 cycles / 16 samples = 0.6 per ms
+    knobLastRead = now;
+
+    uint16_t sample = analogRead(knobPin) << 2;
+    for (uint32_t i = 0; i < samples && i < KNOB_MAX_CATCH_UP; i++)
+    {
+        feedDecimated(sample);
+    }
+    return (knobEma >> KNOB_EMA_SHIFT) >> 2;
+}
+
+#endif
+
+int KnobInput::bucket(int current, int low, int high) const
+{
+    int32_t value = read();
+    int candidate = map(value, 0, KNOB_MAX, low, high);
+    if (candidate == current || current < low || current > high)
+    {
+        return candidate;
+    }
+
+    // First reading that map() places in a given bucket
+    int32_t span = high - low;
+    if (candidate > current)
+    {
+        int32_t edge = ((int32_t)(current + 1 - low) * KNOB_MAX + span - 1) / span;
+        if (value < min(edge + KNOB_HYSTERESIS, (int32_t)KNOB_MAX))
+        {
+            return current;
+        }
+    }
+    else
+    {
+        int32_t edge = ((int32_t)(current - low) * KNOB_MAX + span - 1) / span;
+        if (value > edge - KNOB_HYSTERESIS)
+        {
+            return current;
+        }
+    }
+    return candidate;
+}
@@ -0,0 +1,55 @@
+#include "Log.h"
+#include "SpscQueue.h"
+
+static SpscQueue<uint8_t, LOG_BUFFER_SIZE> logQueue;
+static uint16_t logDroppedRecords;
+
+uint8_t logLevel = LOG_LEVEL;
+
+void logWrite(uint8_t id, uint8_t argc, int16_t a, int16_t b, int16_t c)
+{
+    if (logQueue.space() < 3 + 2 * argc)
+    {
+        logDroppedRecords++;
+        return;
+    }
+
+    int16_t args[3] = {a, b, c};
+    logQueue.push(LOG_SYNC);
+    logQueue.push(id);
+    logQueue.push(argc);
+    for (uint8_t i = 0; i < argc; i++)
+    {
+        logQueue.push(args[i] & 0xFF);
+        logQueue.push((uint16_t)args[i] >> 8);
+    }
+}
+
+void logDrain()
+{
+    int room = Serial.availableForWrite();
+    uint8_t byte;
+    while (room-- > 0 && logQueue.pop(byte))
+    {
+        Serial.write(byte);
+    }
+}
+
+void logFlush()
+{
+    uint8_t byte;
+    while (logQueue.pop(byte))
+    {
+        Serial.write(byte);
+    }
+}
+
+bool logPending()
+{
+    return !logQueue.isEmpty();
+}
+
+uint16_t logDropped()
+{
+    return logDroppedRecords;
+}
@@ -0,0 +1,271 @@
+#include "Power.h"
+
+static PowerStats stats;
+static volatile bool wakeRequested;
+static bool awakeHeld;
+static uint32_t awakeHeldAt;
+
+void powerWake()
+{
+    wakeRequested = true;
+}
+
+void powerStayAwake()
+{
+    awakeHeld = true;
+    awakeHeldAt = millis();
+}
+
+// Whether power-save is held off by powerStayAwake(). If so, the wait is
+// cut short at the end of the hold so power-save can resume then.
+static bool holdingAwake(uint32_t &deadline)
+{
+    if (!awakeHeld)
+    {
+        return false;
+    }
+    uint32_t end = awakeHeldAt + POWER_AWAKE_HOLD_MS;
+    if ((int32_t)(millis() - end) >= 0)
+    {
+        awakeHeld = false;
+        return false;
+    }
+    if ((int32_t)(deadline - end) > 0)
+    {
+        deadline = end;
+    }
+    return true;
+}
+
+#ifdef __AVR__
+
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+// Timer0 state kept by the Arduino core (wiring.c)
+extern volatile unsigned long timer0_millis;
+extern volatile unsigned long timer0_overflow_count;
+
+#define POWER_WAKE_PINS (_BV(PCINT18) | _BV(PCINT19)) // D2 and D3, the buttons
+#define POWER_RX_PIN _BV(PCINT16)                      // D0, the USART's RXD
+
+static volatile bool watchdogFired;
+static uint32_t watchdogBaseMicros = POWER_WDT_BASE_US;
+
+ISR(WDT_vect)
+{
+    watchdogFired = true;
+}
+
+// Watchdog in interrupt-only mode, period 16 ms << prescale
+static void watchdogStart(uint8_t prescale)
+{
+    uint8_t bits = (prescale & 0x07) | (prescale & 0x08 ? _BV(WDP3) : 0);
+    watchdogFired = false;
+    noInterrupts();
+    wdt_reset();
+    MCUSR &= ~_BV(WDRF);
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | bits;
+    interrupts();
+}
+
+// Sleeps until the next interrupt. Interrupts stay off from the wake check
+// to sleep_cpu() so a powerWake() in between is not lost: the instruction
+// after sei always runs before any pending interrupt.
+static void sleepOnce(uint8_t mode)
+{
+    set_sleep_mode(mode);
+    noInterrupts();
+    if (wakeRequested)
+    {
+        interrupts();
+        return;
+    }
+    sleep_enable();
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+}
+
+// Timer0 wakes the CPU every 1.024 ms, which bounds the overshoot. The
+// USART keeps running, and its receive interrupt ends the wait.
+static void idleUntil(uint32_t deadline)
+{
+    uint32_t start = millis();
+    while (!wakeRequested && !Serial.available() && (int32_t)(millis() - deadline) < 0)
+    {
+        sleepOnce(SLEEP_MODE_IDLE);
+    }
+    stats.idleMs += millis() - start;
+}
+
+// The watchdog oscillator is only accurate to about 10%, so one period is
+// timed against Timer0 in idle mode before each power-save wait
+static void calibrateWatchdog()
+{
+    watchdogStart(0);
+    uint32_t start = micros();
+    while (!watchdogFired)
+    {
+        sleepOnce(SLEEP_MODE_IDLE);
+    }
+    watchdogBaseMicros = micros() - start;
+    wdt_disable();
+}
+
+// Moves millis() and micros() on by time spent with Timer0 stopped
+static void addSleptMicros(uint32_t us)
+{
+    noInterrupts();
+    timer0_millis += us / 1000;
+    timer0_overflow_count += us / 1024;
+    interrupts();
+    stats.saveMs += us / 1000;
+}
+
+static void saveUntil(uint32_t deadline)
+{
+    calibrateWatchdog();
+
+    // INT0/INT1 edges need the I/O clock, so the button pins wake through
+    // a pin change instead. The PCINT2 vector is the one SoftwareSerial
+    // defines; it ignores pins it is not listening on.
+    PCMSK2 |= POWER_WAKE_PINS | POWER_RX_PIN;
+    PCIFR = _BV(PCIF2);
+    PCICR |= _BV(PCIE2);
+
+    uint8_t pinsBefore = PIND & POWER_WAKE_PINS;
+    while (!wakeRequested)
+    {
+        int32_t remaining = deadline - millis();
+        if (remaining < (int32_t)POWER_SAVE_MIN_MS)
+        {
+            break;
+        }
+
+        uint8_t prescale = POWER_SAVE_MAX_PRESCALE;
+        while (prescale && (watchdogBaseMicros << prescale) / 1000 > (uint32_t)remaining)
+        {
+            prescale--;
+        }
+        uint32_t period = watchdogBaseMicros << prescale;
+
+        watchdogStart(prescale);
+        sleepOnce(SLEEP_MODE_PWR_SAVE);
+        wdt_disable();
+        stats.saveWakes++;
+
+        if (watchdogFired)
+        {
+            addSleptMicros(period);
+            continue;
+        }
+
+        // Another interrupt ended the period at an unknown point; assume half
+        addSleptMicros(period / 2);
+        if ((PIND & POWER_WAKE_PINS) != pinsBefore)
+        {
+            wakeRequested = true;
+        }
+        else
+        {
+            // A start bit on RXD or the MP3 link, long over by now. Stay in
+            // idle mode, where the USART can receive what follows.
+            powerStayAwake();
+            break;
+        }
+    }
+
+    PCICR &= ~_BV(PCIE2);
+    PCMSK2 &= ~(POWER_WAKE_PINS | POWER_RX_PIN);
+}
+
+void powerIdleUntil(uint32_t deadline, bool allowSave)
+{
+    if (allowSave && !holdingAwake(deadline) && (int32_t)(deadline - millis()) >= (int32_t)POWER_SAVE_MIN_MS && !wakeRequested)
+    {
+        Serial.flush(); // The UART stops with the I/O clock
+        saveUntil(deadline);
+        holdingAwake(deadline); // Started if RXD ended the sleep
+    }
+    idleUntil(deadline);
+    wakeRequested = false;
+}
+
+#else
+#include <HostHAL.h>
+
+// The simulator skips the wait after loop() returns, so the time is
+// credited on the next call, capped at the deadline
+static bool pending;
+static bool pendingSave;
+static uint32_t pendingStart;
+static uint32_t pendingDeadline;
+
+static void settlePending()
+{
+    if (!pending)
+    {
+        return;
+    }
+    pending = false;
+    uint32_t slept = millis() - pendingStart;
+    if (slept > pendingDeadline - pendingStart)
+    {
+        slept = pendingDeadline - pendingStart;
+    }
+    if (pendingSave)
+    {
+        stats.saveMs += slept;
+    }
+    else
+    {
+        stats.idleMs += slept;
+    }
+}
+
+void powerIdleUntil(uint32_t deadline, bool allowSave)
+{
+    settlePending();
+    bool held = allowSave && holdingAwake(deadline);
+    int32_t wait = deadline - millis();
+    if (wait > 0)
+    {
+        pending = true;
+        pendingSave = allowSave && !held && wait >= (int32_t)POWER_SAVE_MIN_MS;
+        pendingStart = millis();
+        pendingDeadline = deadline;
+        if (pendingSave)
+        {
+            stats.saveWakes++;
+        }
+        halIdleUntil(deadline);
+    }
+    wakeRequested = false;
+}
+#endif
+
+const PowerStats &powerStats()
+{
+#ifndef __AVR__
+    settlePending();
+#endif
+    return stats;
+}
+
+void powerPrintStats(Print &out)
+{
+    powerStats();
+    uint32_t asleep = stats.idleMs + stats.saveMs;
+    uint32_t elapsed = millis();
+    out.print(F("asleep: "));
+    out.print(elapsed >= 100 ? asleep / (elapsed / 100) : 0);
+    out.print(F("% (idle "));
+    out.print(stats.idleMs);
+    out.print(F(" ms, power-save "));
+    out.print(stats.saveMs);
+    out.print(F(" ms, "));
+    out.print(stats.saveWakes);
+    out.println(F(" wakes)"));
+}
@@ -0,0 +1,110 @@
+#include <stddef.h>
+#include <EEPROM.h>
+#include "SettingsStore.h"
+
+// CRC-8, polynomial 0x31 (Dallas/Maxim), over the sequence and settings
+static uint8_t crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = 0xFF;
+    while (length--)
+    {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint16_t slotAddress(uint8_t slot)
+{
+    return SETTINGS_EEPROM_BASE + slot * sizeof(SettingsRecord);
+}
+
+static bool sameSettings(const Settings &a, const Settings &b)
+{
+    return memcmp(&a, &b, sizeof(Settings)) == 0;
+}
+
+bool SettingsStore::load(Settings &settings)
+{
+    bool found = false;
+    uint8_t newest = 0;
+    SettingsRecord record;
+    SettingsRecord best;
+
+    for (uint8_t slot = 0; slot < SETTINGS_SLOT_COUNT; slot++)
+    {
+        EEPROM.get(slotAddress(slot), record);
+        if (record.crc != crc8((const uint8_t *)&record, offsetof(SettingsRecord, crc)))
+        {
+            continue; // Erased, torn or corrupt
+        }
+        if (!found || (int16_t)(record.sequence - best.sequence) > 0)
+        {
+            best = record;
+            newest = slot;
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+    settings = best.settings;
+    committed = best.settings;
+    sequence = best.sequence;
+    nextSlot = (newest + 1) % SETTINGS_SLOT_COUNT;
+    return true;
+}
+
+void SettingsStore::update(const Settings &settings, uint32_t now)
+{
+    if (!dirty && sameSettings(settings, committed))
+    {
+        return;
+    }
+    pending = settings;
+    dirty = true;
+    changedAt = now;
+}
+
+void SettingsStore::poll(uint32_t now)
+{
+    if (writeOffset == 0)
+    {
+        if (!dirty || now - changedAt < SETTINGS_COMMIT_DELAY_MS)
+        {
+            return;
+        }
+        dirty = false;
+        if (sameSettings(pending, committed))
+        {
+            return; // Changed and changed back
+        }
+
+        outgoing.sequence = sequence + 1;
+        outgoing.settings = pending;
+        outgoing.crc = crc8((const uint8_t *)&outgoing, offsetof(SettingsRecord, crc));
+    }
+
+#ifdef __AVR__
+    if (!eeprom_is_ready())
+    {
+        return; // Previous byte still programming
+    }
+#endif
+
+    EEPROM.update(slotAddress(nextSlot) + writeOffset, ((const uint8_t *)&outgoing)[writeOffset]);
+    if (++writeOffset < sizeof(SettingsRecord))
+    {
+        return;
+    }
+
+    writeOffset = 0;
+    committed = outgoing.settings;
+    sequence = outgoing.sequence;
+    nextSlot = (nextSlot + 1) % SETTINGS_SLOT_COUNT;
+}
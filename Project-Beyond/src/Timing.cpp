@@ -0,0 +1,46 @@
+#include "Timing.h"
+
+#ifdef TIMING_ENABLED
+
+static LatencyHistogram histograms[STAGE_COUNT];
+
+static const char stageUpdate[] PROGMEM = "update";
+static const char stageModeSwitch[] PROGMEM = "modeSwitch";
+static const char stageKnob[] PROGMEM = "knob";
+static const char stagePressureButton[] PROGMEM = "pressureButton";
+static const char stageShowStrips[] PROGMEM = "show strips";
+static const char stageConsole[] PROGMEM = "console";
+
+static const char *const stageNames[STAGE_COUNT] PROGMEM = {
+    stageUpdate,
+    stageModeSwitch,
+    stageKnob,
+    stagePressureButton,
+    stageShowStrips,
+    stageConsole,
+};
+
+void timingRecord(uint8_t stage, uint32_t us)
+{
+    histograms[stage].record(us);
+}
+
+void timingReport(Print &out)
+{
+    out.println(F("stage: n min max p99 (us)"));
+    for (uint8_t i = 0; i < STAGE_COUNT; i++)
+    {
+        const LatencyHistogram &h = histograms[i];
+        out.print(reinterpret_cast<const __FlashStringHelper *>(pgm_read_ptr(&stageNames[i])));
+        out.print(F(": "));
+        out.print(h.getSamples());
+        out.print(' ');
+        out.print(h.getMin());
+        out.print(' ');
+        out.print(h.getMax());
+        out.print(' ');
+        out.println(h.percentile(99));
+    }
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "WallClock.h"
+
+#ifdef __AVR__
+// The Uno build has no RTC fitted and relies on CLOCK_TRIM_PPM
+RtcSource *boardRtc()
+{
+    return 0;
+}
+#else
+#include <HostHAL.h>
+
+// Mock RTC following the simulator's true time, which differs from
+// millis() by the drift set with --drift-ppm
+class HostRtc : public RtcSource
+{
+public:
+    bool read(uint32_t &seconds)
+    {
+        return halRtcRead(&seconds);
+    }
+};
+
+static HostRtc hostRtc;
+
+RtcSource *boardRtc()
+{
+    return &hostRtc;
+}
+#endif
+
+void WallClock::begin(uint32_t now, RtcSource *source)
+{
+    rtc = source;
+    lastTick = now;
+    discipline(now);
+}
+
+void WallClock::advance(uint32_t now)
+{
+    uint32_t elapsed = now - lastTick;
+    lastTick = now;
+    ticksSinceReference += elapsed;
+
+    // Chunked so chunk * trimPpm cannot overflow after a long idle
+    while (elapsed)
+    {
+        uint32_t chunk = elapsed > CLOCK_CHUNK_MS ? CLOCK_CHUNK_MS : elapsed;
+        elapsed -= chunk;
+
+        driftResidual += (int32_t)chunk * trimPpm;
+        int32_t correction = driftResidual / 1000000L;
+        driftResidual -= correction * 1000000L;
+
+        uint32_t total = milliseconds + chunk + correction;
+        seconds += total / 1000;
+        milliseconds = total % 1000;
+    }
+}
+
+bool WallClock::discipline(uint32_t now)
+{
+    advance(now);
+
+    uint32_t rtcSeconds;
+    if (!rtc || !rtc->read(rtcSeconds))
+    {
+        return false;
+    }
+
+    if (!synced)
+    {
+        synced = true;
+        rtcReference = rtcSeconds;
+        ticksSinceReference = 0;
+    }
+    else if (ticksSinceReference >= CLOCK_DISCIPLINE_MS)
+    {
+        // Ticks the RTC says should have passed against those that did; the
+        // RTC's one-second resolution averages out over longer spans. In 64
+        // bits, as the RTC may have been set hours away.
+        int32_t rtcElapsed = (int32_t)(rtcSeconds - rtcReference);
+        int64_t errorMs = (int64_t)rtcElapsed * 1000 - ticksSinceReference;
+        int64_t ppm = errorMs * 1000 / (int32_t)(ticksSinceReference / 1000);
+
+        if (rtcElapsed < 0 || ppm < -CLOCK_TRIM_LIMIT_PPM || ppm > CLOCK_TRIM_LIMIT_PPM)
+        {
+            // The RTC was set or misread: keep the trim and measure afresh
+            rtcReference = rtcSeconds;
+            ticksSinceReference = 0;
+        }
+        else
+        {
+            trimPpm = ppm;
+            if (ticksSinceReference >= CLOCK_REFERENCE_SPAN_MS)
+            {
+                rtcReference = rtcSeconds;
+                ticksSinceReference = 0;
+            }
+        }
+    }
+
+    seconds = rtcSeconds;
+    milliseconds = 0;
+    driftResidual = 0;
+    return true;
+}
+
+uint32_t WallClock::ticksUntil(uint32_t target, uint32_t nowTicks)
+{
+    advance(nowTicks);
+    int32_t remaining = (int32_t)(target - seconds) * 1000L - milliseconds;
+    if (remaining <= 0)
+    {
+        return 0;
+    }
+    // Inverse of the trim, to first order; exact to 1 ppm for trims under 0.1%
+    return remaining - remaining / 1000 * trimPpm / 1000;
+}
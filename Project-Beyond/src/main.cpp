@@ -2,17 +2,86 @@
 #include <SoftwareSerial.h>
 #include <RedMP3.h>
 #include <Adafruit_NeoPixel.h>
+#include "Scheduler.h"
+#include "ButtonInput.h"
+#include "KnobInput.h"
+#include "Timeline.h"
+#include "StripRenderer.h"
+#include "Log.h"
+#include "Timing.h"
+#include "SettingsStore.h"
+#include "WallClock.h"
+#include "Power.h"
+#include "Console.h"
 
-#define MODE_BUTTON 3
-#define PRESSURE_BUTTON 2
-#define FEEDBACK_LED 6
-#define KNOB A1
-#define MP3_RX 8
-#define MP3_TX 9
-#define NEOPIXEL_PIN 4
-#define NUMPIXELS 15
-#define SECOND_STRIP_PIN 5
-#define SECOND_NUMPIXELS 15
+// Wiring of the Uno build. The controller takes this as a template
+// argument, so pin numbers and strip lengths are compile-time constants.
+struct UnoBoard
+{
+    static const uint8_t modeButton = 3;
+    static const uint8_t pressureButton = 2;
+    static const uint8_t feedbackLed = 6;
+    static const uint8_t knob = A1;
+    static const uint8_t mp3Rx = 8;
+    static const uint8_t mp3Tx = 9;
+    static const uint8_t stripPin = 4; // Both strips on PORTD, so showGroup() interleaves them
+    static const uint16_t stripLength = 15;
+    static const uint8_t secondStripPin = 5;
+    static const uint16_t secondStripLength = 15;
+};
+
+#define STRIP_INTERRUPT_WINDOW_US 60 // show() lets interrupts in at least this often, for SoftwareSerial and millis()
+#define STRIP_CURRENT_LIMIT_MA 200 // Per strip: both strips, the Uno and the MP3 module stay within USB's 500 mA
+
+#define KNOB_POLL_MS 50
+#define KNOB_TAKEOVER 32 // Counts the knob must move from its boot position before it overrides restored settings
+#define SETTINGS_POLL_MS 10
+#define INTRO_SOUND_MS 3000
+#define DIM_START_MS 500
+#define DIM_STEP_MS 100
+#define SECONDS_PER_WAKEUP_UNIT 3600UL // wakeupTime is in hours after the sunset ends
+#define SUNRISE_STEP_MS 100
+#define DITHER_FRAME_MS 5 // Second strip refresh during fades, fast enough that dithering doesn't flicker
+#define COMMAND_NAME_SIZE 8
+
+// Sunset profiles played while dimming, one tick per DIM_STEP_MS
+const Keyframe classicSunset[] PROGMEM = {
+    {0, 255, 0, 0, 15, TIMELINE_LINEAR},
+    {51, 0, 0, 0, 0, TIMELINE_LINEAR},
+};
+
+const Keyframe emberSunset[] PROGMEM = {
+    {0, 255, 40, 0, 15, TIMELINE_LINEAR},
+    {100, 140, 10, 0, 10, TIMELINE_LINEAR},
+    {250, 30, 0, 0, 4, TIMELINE_LINEAR},
+    {300, 0, 0, 0, 0, TIMELINE_LINEAR},
+};
+
+const TimelineProfile sunsetProfiles[] PROGMEM = {
+    {classicSunset, sizeof(classicSunset) / sizeof(Keyframe)},
+    {emberSunset, sizeof(emberSunset) / sizeof(Keyframe)},
+};
+
+// Sunrise profiles, one tick per SUNRISE_STEP_MS
+const Keyframe classicSunrise[] PROGMEM = {
+    {0, 0, 0, 0, 0, TIMELINE_LINEAR},
+    {50, 250, 50, 0, 10, TIMELINE_LINEAR},
+};
+
+const Keyframe dawnSunrise[] PROGMEM = {
+    {0, 0, 0, 0, 0, TIMELINE_LINEAR},
+    {150, 80, 5, 0, 3, TIMELINE_LINEAR},
+    {450, 255, 80, 10, 8, TIMELINE_LINEAR},
+    {600, 255, 160, 60, 10, TIMELINE_LINEAR},
+};
+
+const TimelineProfile sunriseProfiles[] PROGMEM = {
+    {classicSunrise, sizeof(classicSunrise) / sizeof(Keyframe)},
+    {dawnSunrise, sizeof(dawnSunrise) / sizeof(Keyframe)},
+};
+
+#define SUNSET_PROFILE_COUNT (sizeof(sunsetProfiles) / sizeof(TimelineProfile))
+#define SUNRISE_PROFILE_COUNT (sizeof(sunriseProfiles) / sizeof(TimelineProfile))
 
 enum Mode
 {
@@ -20,36 +89,138 @@ enum Mode
     SET_RED_LIGHT_TIME
 };
 
+enum NightState
+{
+    NIGHT_IDLE,
+    NIGHT_INTRO,
+    NIGHT_DIMMING,
+    NIGHT_DARK,
+    NIGHT_SUNRISE,
+    NIGHT_HOLD,
+    NIGHT_ABORT,
+    NIGHT_STATE_COUNT,
+    NIGHT_STAY = NIGHT_STATE_COUNT // Transition column value meaning "no transition"
+};
+
+template <class Board>
 class LightAndMusicController
 {
 private:
+    typedef void (LightAndMusicController::*StateHandler)();
+    typedef void (LightAndMusicController::*CommandHandler)(uint8_t argc, char **argv);
+
+    // One row per NightState. Handlers may be null; whilePressed/whileReleased
+    // name the state to enter while the pressure button is in that level.
+    struct NightStateHandlers
+    {
+        StateHandler entry;
+        StateHandler tick;
+        StateHandler exit;
+        uint8_t whilePressed;
+        uint8_t whileReleased;
+    };
+
+    static const NightStateHandlers nightStates[NIGHT_STATE_COUNT];
+
+    // Serial console commands; the table ends with an empty name
+    struct ConsoleCommand
+    {
+        char name[COMMAND_NAME_SIZE];
+        CommandHandler handler;
+    };
+
+    static const ConsoleCommand commands[];
+
     MP3 mp3;
-    Adafruit_NeoPixel strip;
-    Adafruit_NeoPixel secondStrip;
+    StaticNeoPixel<Board::stripLength> strip;
+    StaticNeoPixel<Board::secondStripLength> secondStrip;
+    uint8_t stripWire[StaticNeoPixel<Board::stripLength>::bufferBytes]; // Current-limited copy sent by show()
+    uint8_t secondStripWire[StaticNeoPixel<Board::secondStripLength>::bufferBytes]; // Brightness-scaled copy sent by show()
+    uint16_t secondStripDither[StaticNeoPixel<Board::secondStripLength>::ditherWords]; // Q8.8 levels for fades below 8-bit steps
+#ifdef NEO_FRONT_BUFFER
+    // Frames being sent while the next ones are drawn, on backends that need them
+    uint8_t stripFront[StaticNeoPixel<Board::stripLength>::bufferBytes];
+    uint8_t secondStripFront[StaticNeoPixel<Board::secondStripLength>::bufferBytes];
+#endif
+    StripRenderer<Board::stripLength> stripRenderer;
+    StripRenderer<Board::secondStripLength> secondStripRenderer;
+    Scheduler scheduler;
+    ButtonInput buttons;
+    KnobInput knob;
+    SettingsStore settingsStore;
+    WallClock clock;
+    Console console;
     Mode currentMode;
     int wakeupTime;
     int redLightTime;
     int brightness;
-    float volume;
-    bool dimming;
+    int volume;
     int previousBrightness;
-    float previousVolume;
+    int previousVolume;
     int musicIndex;
     bool settingMode;
+    NightState nightState;
+    Timeline timeline;
+    uint8_t sunsetProfile;
+    uint8_t sunriseProfile;
+    int8_t knobTask;
+    int8_t nightTask;
+    int8_t settingsTask;
+    int8_t clockTask;
+    int8_t ditherTask;
+    uint32_t darkStartedAt; // Clock seconds at which the dark phase began
+    uint32_t wakeupAt;      // Clock seconds at which the sunrise starts
+    uint32_t timelineStepAt; // millis() at which the timeline's next tick is due
+    uint16_t timelineStepMs;
+    bool knobEngaged;
+    uint16_t knobReference; // Reading when the settings were last set by other means
 
 public:
-    LightAndMusicController(int mp3Rx, int mp3Tx, int neoPixelPin, int numPixels, int secondNeoPixelPin, int secondNumPixels)
-        : mp3(mp3Rx, mp3Tx), strip(numPixels, neoPixelPin, NEO_GRB + NEO_KHZ800), secondStrip(secondNumPixels, secondNeoPixelPin, NEO_GRB + NEO_KHZ800), currentMode(SET_WAKEUP_TIME), wakeupTime(1), redLightTime(1), brightness(255), volume(0), dimming(false), previousBrightness(255), previousVolume(0), musicIndex(1), settingMode(false) {}
+    LightAndMusicController()
+        : mp3(Board::mp3Rx, Board::mp3Tx), strip(Board::stripPin), secondStrip(Board::secondStripPin), stripRenderer(strip), secondStripRenderer(secondStrip), console(Serial), currentMode(SET_WAKEUP_TIME), wakeupTime(1), redLightTime(1), brightness(255), volume(0), previousBrightness(255), previousVolume(0), musicIndex(1), settingMode(false), nightState(NIGHT_IDLE), sunsetProfile(0), sunriseProfile(0), darkStartedAt(0), wakeupAt(0), timelineStepAt(0), timelineStepMs(1), knobEngaged(false), knobReference(0) {}
 
     void initialize()
     {
-        pinMode(MODE_BUTTON, INPUT);
-        pinMode(PRESSURE_BUTTON, INPUT);
-        pinMode(FEEDBACK_LED, OUTPUT);
-        pinMode(KNOB, INPUT);
+        pinMode(Board::modeButton, INPUT);
+        pinMode(Board::pressureButton, INPUT);
+        pinMode(Board::feedbackLed, OUTPUT);
+        pinMode(Board::knob, INPUT);
+        buttons.begin<Board::pressureButton, Board::modeButton>();
+        knob.begin(Board::knob);
+        knobReference = knob.read();
 
         Serial.begin(9600);
-        Serial.println("Serial communication started at 9600 baud");
+        LOG_INFO(LOG_SERIAL_STARTED);
+
+        Settings settings;
+        if (settingsStore.load(settings))
+        {
+            wakeupTime = settings.wakeupTime;
+            redLightTime = settings.redLightTime;
+            musicIndex = settings.musicIndex;
+            LOG_INFO(LOG_SETTINGS_RESTORED, wakeupTime, redLightTime, musicIndex);
+        }
+
+        clock.begin(millis(), boardRtc());
+
+        strip.setCurrentLimit(STRIP_CURRENT_LIMIT_MA);
+        secondStrip.setCurrentLimit(STRIP_CURRENT_LIMIT_MA);
+        // SoftwareSerial's receive handler holds the CPU for a whole byte
+        // from the MP3 module, about 1 ms at 9600 baud, far past
+        // NEO_RESUME_LIMIT_US. A frame such a byte lands in is cut short, the
+        // strip latching it part-updated, and StripRenderer sends it again on
+        // the next pass (test_chunked_show). The module only sends replies
+        // and status, so that costs an occasional frame; without the window
+        // its handler would start a whole frame late and misread the byte.
+        strip.setInterruptWindow(STRIP_INTERRUPT_WINDOW_US);
+        secondStrip.setInterruptWindow(STRIP_INTERRUPT_WINDOW_US);
+        strip.setOutputBuffer(stripWire, sizeof(stripWire)); // Limited frames need no heap
+        secondStrip.setOutputBuffer(secondStripWire, sizeof(secondStripWire)); // Brightness changes rewrite no pixels
+        secondStrip.setDitherBuffer(secondStripDither, StaticNeoPixel<Board::secondStripLength>::ditherWords);
+#ifdef NEO_FRONT_BUFFER
+        strip.setFrontBuffer(stripFront, sizeof(stripFront));
+        secondStrip.setFrontBuffer(secondStripFront, sizeof(secondStripFront));
+#endif
 
         strip.begin();
         strip.show(); // Initialize all pixels to 'off'
@@ -59,215 +230,654 @@ public:
 
         // Set initial white light on the second LED strip
         setSecondStripColor(secondStrip.Color(255, 255, 255));
+
+        knobTask = scheduler.add(F("knob"), onKnob, this);
+        nightTask = scheduler.add(F("night"), onNightTick, this);
+        settingsTask = scheduler.add(F("settings"), onSettingsPoll, this);
+        clockTask = scheduler.add(F("clock"), onClockDiscipline, this);
+        ditherTask = scheduler.add(F("dither"), onDitherFrame, this);
+
+        scheduler.startPeriodic(knobTask, KNOB_POLL_MS, 0, millis());
+        scheduler.startPeriodic(clockTask, CLOCK_DISCIPLINE_MS, CLOCK_DISCIPLINE_MS, millis());
     }
 
+    // Never blocks: button edges are captured by interrupts and drained on
+    // every pass, and all timed work is dispatched by the scheduler
     void update()
     {
-        handleModeSwitch();
+        {
+            TIME_STAGE(STAGE_UPDATE);
 
-        switch (currentMode)
+            ButtonEvent change;
+            for (uint8_t i = 0; i < BUTTON_QUEUE_SIZE && buttons.poll(change, micros()); i++)
+            {
+                if (change.button == BUTTON_MODE && change.level == HIGH)
+                {
+                    handleModeSwitch();
+                }
+            }
+            handlePressureButton();
+            scheduler.run(millis());
+            pollConsole();
+
+            // At most one show() per strip per pass, and none if nothing changed
+            showStrips();
+
+            // Whatever TX buffer space is left goes to queued log records
+            logDrain();
+        }
+
+        // Nothing left to do until the next task is due. Only the dark phase,
+        // with the knob stopped and the console quiet, may use power-save.
+        uint32_t deadline;
+        if (buttons.isSettled() && !logPending() && !Serial.available() && scheduler.nextDeadline(deadline))
         {
-        case SET_WAKEUP_TIME:
-            setWakeupTime();
-            break;
-        case SET_RED_LIGHT_TIME:
-            setRedLightTime();
-            break;
+            bool dark = nightState == NIGHT_DARK;
+            powerIdleUntil(deadline, dark);
+            if (dark)
+            {
+                buttons.resync();
+            }
+        }
+    }
+
+    // Profiles take effect the next time their phase starts
+    void setSunsetProfile(uint8_t index)
+    {
+        if (index < SUNSET_PROFILE_COUNT)
+        {
+            sunsetProfile = index;
+        }
+    }
+
+    void setSunriseProfile(uint8_t index)
+    {
+        if (index < SUNRISE_PROFILE_COUNT)
+        {
+            sunriseProfile = index;
         }
+    }
 
-        handlePressureButton();
+    void printStats()
+    {
+        logFlush();
+        scheduler.printStats(Serial);
+        Serial.print(F("button events dropped: "));
+        Serial.println(buttons.getDropped());
+        Serial.print(F("strip shows/skipped: "));
+        Serial.print(stripRenderer.getShows());
+        Serial.print('/');
+        Serial.println(stripRenderer.getSkipped());
+        Serial.print(F("second strip shows/skipped: "));
+        Serial.print(secondStripRenderer.getShows());
+        Serial.print('/');
+        Serial.println(secondStripRenderer.getSkipped());
+        Serial.print(F("strip mA/limited shows: "));
+        Serial.print(strip.getCurrentEstimate());
+        Serial.print('/');
+        Serial.println(strip.getLimitedShows());
+        Serial.print(F("second strip mA/limited shows: "));
+        Serial.print(secondStrip.getCurrentEstimate());
+        Serial.print('/');
+        Serial.println(secondStrip.getLimitedShows());
+        Serial.print(F("aborted shows: "));
+        Serial.print(strip.getAbortedShows());
+        Serial.print('/');
+        Serial.println(secondStrip.getAbortedShows());
+        Serial.print(F("log records dropped: "));
+        Serial.println(logDropped());
+        Serial.print(F("console lines discarded: "));
+        Serial.println(console.getDiscarded());
+        powerPrintStats(Serial);
     }
 
 private:
+    static void onKnob(void *self) { static_cast<LightAndMusicController *>(self)->handleKnob(); }
+    static void onNightTick(void *self) { static_cast<LightAndMusicController *>(self)->tickNightState(); }
+    static void onSettingsPoll(void *self) { static_cast<LightAndMusicController *>(self)->pollSettings(); }
+    static void onClockDiscipline(void *self) { static_cast<LightAndMusicController *>(self)->disciplineClock(); }
+    static void onDitherFrame(void *self) { static_cast<LightAndMusicController *>(self)->glideSecondStrip(); }
+
     void handleModeSwitch()
     {
-        if (digitalRead(MODE_BUTTON) == HIGH)
+        TIME_STAGE(STAGE_MODE_SWITCH);
+        currentMode = static_cast<Mode>((currentMode + 1) % 2); // Toggle between SET_WAKEUP_TIME and SET_RED_LIGHT_TIME
+        settingMode = true;
+        LOG_INFO(currentMode == SET_WAKEUP_TIME ? LOG_MODE_WAKEUP_TIME : LOG_MODE_RED_LIGHT_TIME);
+        mp3.playWithVolume((currentMode + 2), 10);
+
+        // Update NeoPixel strip based on mode
+        if (currentMode == SET_WAKEUP_TIME)
         {
-            currentMode = static_cast<Mode>((currentMode + 1) % 2); // Toggle between SET_WAKEUP_TIME and SET_RED_LIGHT_TIME
-            settingMode = true;
-            Serial.print("Mode switched to: ");
-            Serial.println(currentMode == SET_WAKEUP_TIME ? "SET_WAKEUP_TIME" : "SET_RED_LIGHT_TIME");
-            mp3.playWithVolume((currentMode + 2), 10);
-            delay(500); // Debounce delay
+            setStripColor(strip.Color(0, 0, 100)); // Blue for SET_WAKEUP_TIME
+        }
+        else
+        {
+            setStripColor(strip.Color(100, 0, 0)); // Red for SET_RED_LIGHT_TIME
+        }
+    }
 
-            // Update NeoPixel strip based on mode
-            if (currentMode == SET_WAKEUP_TIME)
-            {
-                setStripColor(strip.Color(0, 0, 100)); // Blue for SET_WAKEUP_TIME
-            }
-            else
+    void handleKnob()
+    {
+        TIME_STAGE(STAGE_KNOB);
+
+        // Restored settings stand until the knob is actually turned
+        if (!knobEngaged)
+        {
+            int16_t moved = (int16_t)knob.read() - (int16_t)knobReference;
+            if (moved > -KNOB_TAKEOVER && moved < KNOB_TAKEOVER)
             {
-                setStripColor(strip.Color(100, 0, 0)); // Red for SET_RED_LIGHT_TIME
+                return;
             }
+            knobEngaged = true;
+        }
+
+        switch (currentMode)
+        {
+        case SET_WAKEUP_TIME:
+            setWakeupTime();
+            break;
+        case SET_RED_LIGHT_TIME:
+            setRedLightTime();
+            break;
         }
     }
 
+    // Settings restored or set from the console hold until the knob moves
+    // KNOB_TAKEOVER counts from where it is now
+    void releaseKnob()
+    {
+        knobEngaged = false;
+        knobReference = knob.read();
+    }
+
     void setWakeupTime()
     {
-        int newWakeupTime = map(analogRead(KNOB), 0, 1023, 1, 8);
-        delay(50); // Add a small delay to debounce the knob input
+        int newWakeupTime = knob.bucket(wakeupTime, 1, 8);
         if (newWakeupTime != wakeupTime)
         {
             wakeupTime = newWakeupTime;
-            Serial.print("Wakeup Time set to: ");
-            Serial.println(wakeupTime);
+            LOG_INFO(LOG_WAKEUP_TIME_SET, wakeupTime);
+            saveSettings();
             updateStripColor(strip.Color(0, 0, 255), wakeupTime); // Blue intensity based on wakeup time
         }
     }
 
     void setRedLightTime()
     {
-        int newRedLightTime = map(analogRead(KNOB), 0, 1023, 1, 30);
-        delay(50); // Add a small delay to debounce the knob input
+        int newRedLightTime = knob.bucket(redLightTime, 1, 30);
         if (newRedLightTime != redLightTime)
         {
             redLightTime = newRedLightTime;
-            Serial.print("Red Light Time set to: ");
-            Serial.println(redLightTime);
+            LOG_INFO(LOG_RED_LIGHT_TIME_SET, redLightTime);
+            saveSettings();
             updateStripColor(strip.Color(255, 0, 0), redLightTime); // Red intensity based on red light time
         }
     }
 
-    void updateStripColor(uint32_t color, int value)
+    void saveSettings()
     {
-        int numPixelsToLight = value; // Directly use the value for the number of pixels
-        for (int i = 0; i < NUMPIXELS; i++)
+        Settings settings;
+        settings.wakeupTime = wakeupTime;
+        settings.redLightTime = redLightTime;
+        settings.musicIndex = musicIndex;
+        settingsStore.update(settings, millis());
+        if (!scheduler.isActive(settingsTask))
         {
-            if (i < numPixelsToLight)
-            {
-                strip.setPixelColor(i, color);
-            }
-            else
+            scheduler.startPeriodic(settingsTask, SETTINGS_POLL_MS, 0, millis());
+        }
+    }
+
+    // Runs only while a change is pending so it does not hold the loop awake
+    void pollSettings()
+    {
+        settingsStore.poll(millis());
+        if (!settingsStore.isBusy())
+        {
+            scheduler.cancel(settingsTask);
+        }
+    }
+
+    void disciplineClock()
+    {
+        if (clock.discipline(millis()))
+        {
+            LOG_DEBUG(LOG_CLOCK_TRIM, clock.getTrim());
+            if (nightState == NIGHT_DARK)
             {
-                strip.setPixelColor(i, 0); // Turn off the remaining pixels
+                armWakeup(); // The clock may have been stepped
             }
         }
-        strip.show();
+    }
+
+    void updateStripColor(uint32_t color, int value)
+    {
+        stripRenderer.fill(color, value); // Directly use the value for the number of pixels
     }
 
     void handlePressureButton()
     {
-        if (digitalRead(PRESSURE_BUTTON) == HIGH)
+        TIME_STAGE(STAGE_PRESSURE_BUTTON);
+        NightStateHandlers row;
+        memcpy_P(&row, &nightStates[nightState], sizeof(row));
+
+        uint8_t next = buttons.isDown(BUTTON_PRESSURE) ? row.whilePressed : row.whileReleased;
+        if (next != NIGHT_STAY)
         {
-            if (!dimming)
-            {
-                mp3.playWithVolume(4, 10);
-                delay(3000); // Play the init sound for 3 seconds
-
-                volume = 15; // Set volume to 15 when starting the dimming process
-                mp3.playWithVolume(musicIndex, volume);
-                Serial.println("Playing noise from MP3 player at volume 15");
-                setSecondStripColor(secondStrip.Color(255, 0, 0)); // Red light on the second LED strip
-                dimming = true;
-                brightness = 255;
-                Serial.println("Pressure button pressed: Playing noise and emitting red light");
-                delay(500); // Debounce delay
-
-                // Turn off the main LED strip
-                setStripColor(strip.Color(0, 0, 0));
-            }
+            enterNightState(static_cast<NightState>(next));
         }
-        else
+    }
+
+    // Runs the exit handler of the current state and the entry handler of
+    // the next one. Entry handlers arm nightTask for their first tick.
+    void enterNightState(NightState next)
+    {
+        NightStateHandlers row;
+        memcpy_P(&row, &nightStates[nightState], sizeof(row));
+        scheduler.cancel(nightTask);
+        scheduler.cancel(ditherTask);
+        if (row.exit)
+        {
+            (this->*row.exit)();
+        }
+
+        nightState = next;
+        memcpy_P(&row, &nightStates[nightState], sizeof(row));
+        if (row.entry)
+        {
+            (this->*row.entry)();
+        }
+    }
+
+    void tickNightState()
+    {
+        NightStateHandlers row;
+        memcpy_P(&row, &nightStates[nightState], sizeof(row));
+        if (row.tick)
+        {
+            (this->*row.tick)();
+        }
+    }
+
+    void introEntry()
+    {
+        mp3.playWithVolume(4, 10);
+        scheduler.startOnce(nightTask, INTRO_SOUND_MS, millis()); // Play the init sound for 3 seconds
+    }
+
+    void introTick()
+    {
+        enterNightState(NIGHT_DIMMING);
+    }
+
+    void dimmingEntry()
+    {
+        startTimeline(sunsetProfiles[sunsetProfile], DIM_STEP_MS, DIM_START_MS);
+        volume = timeline.volume();
+        brightness = timeline.red();
+        mp3.playWithVolume(musicIndex, volume);
+        LOG_INFO(LOG_PLAYING_NOISE, volume);
+        glideSecondStrip(); // Red light on the second LED strip
+        LOG_INFO(LOG_PRESSURE_PRESSED);
+
+        // Turn off the main LED strip
+        setStripColor(strip.Color(0, 0, 0));
+
+        scheduler.startPeriodic(nightTask, DIM_STEP_MS, DIM_START_MS, millis());
+    }
+
+    void dimmingTick()
+    {
+        if (timeline.isDone())
+        {
+            enterNightState(NIGHT_DARK);
+            return;
+        }
+
+        stepTimeline(DIM_STEP_MS);
+        brightness = timeline.red();
+        volume = timeline.volume();
+        analogWrite(LED_BUILTIN, brightness);
+        glideSecondStrip(); // Adjust brightness on the second LED strip
+        mp3.setVolume(volume);
+        LOG_DEBUG(LOG_DIMMING_STEP, brightness, volume);
+    }
+
+    // Starts a profile ticking every stepMs after firstStepMs, with the
+    // second strip gliding between ticks
+    void startTimeline(const TimelineProfile &stored, uint16_t stepMs, uint32_t firstStepMs)
+    {
+        TimelineProfile profile;
+        memcpy_P(&profile, &stored, sizeof(profile));
+        timeline.begin(profile);
+        timelineStepMs = stepMs;
+        timelineStepAt = millis() + firstStepMs;
+        scheduler.startPeriodic(ditherTask, DITHER_FRAME_MS, DITHER_FRAME_MS, millis());
+    }
+
+    void stepTimeline(uint16_t stepMs)
+    {
+        timeline.step();
+        timelineStepAt = millis() + stepMs;
+    }
+
+    // Shows the timeline's color as far toward its next tick as time has
+    // gone, so with dithering the fade moves on every frame instead of in
+    // whole 8-bit steps every tick
+    void glideSecondStrip()
+    {
+        int32_t remaining = (int32_t)(timelineStepAt - millis());
+        remaining = constrain(remaining, 0, (int32_t)timelineStepMs);
+        uint16_t phase = (uint32_t)(timelineStepMs - remaining) * 256 / timelineStepMs;
+        if (phase > 255)
+        {
+            phase = 255;
+        }
+        secondStripRenderer.fade16(timeline.red16(phase), timeline.green16(phase), timeline.blue16(phase));
+    }
+
+    // The knob is not read in the dark; stopping its free-running ADC lets
+    // the loop sleep in power-save until the sunrise
+    void darkEntry()
+    {
+        scheduler.cancel(knobTask);
+        knob.end();
+
+        setSecondStripColor(secondStrip.Color(0, 0, 0)); // Turn off the second LED strip
+        mp3.setVolume(0);
+        LOG_INFO(LOG_DIMMING_COMPLETE);
+
+        darkStartedAt = clock.now(millis());
+        scheduleWakeup();
+    }
+
+    // Also called when wakeupTime changes during the night
+    void scheduleWakeup()
+    {
+        wakeupAt = darkStartedAt + wakeupTime * SECONDS_PER_WAKEUP_UNIT;
+        LOG_INFO(LOG_WAKEUP_SCHEDULED, (int16_t)((wakeupAt - clock.now(millis())) / 60));
+        armWakeup();
+    }
+
+    // One-shot for the wall time left until wakeupAt, converted to ticks
+    // through the clock's trim
+    void armWakeup()
+    {
+        scheduler.startOnce(nightTask, clock.ticksUntil(wakeupAt, millis()), millis());
+    }
+
+    void darkTick()
+    {
+        if (clock.ticksUntil(wakeupAt, millis()))
         {
-            if (dimming)
+            armWakeup(); // Woken early by a clock step
+            return;
+        }
+        enterNightState(NIGHT_SUNRISE);
+    }
+
+    void darkExit()
+    {
+        knob.begin(Board::knob);
+        scheduler.startPeriodic(knobTask, KNOB_POLL_MS, 0, millis());
+    }
+
+    void sunriseEntry()
+    {
+        LOG_INFO(LOG_SUNRISE_START);
+
+        // Bring the LEDs up to orange and the nature sounds up to volume 10
+        startTimeline(sunriseProfiles[sunriseProfile], SUNRISE_STEP_MS, 0);
+        scheduler.startPeriodic(nightTask, SUNRISE_STEP_MS, 0, millis());
+    }
+
+    void sunriseTick()
+    {
+        bool done = timeline.isDone();
+        stepTimeline(SUNRISE_STEP_MS);
+        volume = timeline.volume();
+
+        mp3.setVolume(volume);
+        glideSecondStrip(); // Orange light on the second LED strip
+        LOG_DEBUG(LOG_SUNRISE_STEP, volume, timeline.red(), timeline.green());
+
+        if (done)
+        {
+            if (buttons.isDown(BUTTON_PRESSURE))
+            {
+                enterNightState(NIGHT_HOLD);
+            }
+            else
             {
-                dimming = false;
-                setSecondStripColor(secondStrip.Color(255, 255, 255)); // Set white light on the second LED strip
                 mp3.setVolume(0);
-                Serial.println("Pressure button released: Light and volume turned off. Returning to white light.");
-                setStripColor(strip.Color(0, 0, 0)); // Turn off the main LED strip
+                enterNightState(NIGHT_IDLE);
             }
         }
+    }
+
+    void holdEntry()
+    {
+        LOG_INFO(LOG_HOLDING);
+    }
+
+    void abortEntry()
+    {
+        setSecondStripColor(secondStrip.Color(255, 255, 255)); // Set white light on the second LED strip
+        mp3.setVolume(0);
+        LOG_INFO(LOG_PRESSURE_RELEASED);
+        setStripColor(strip.Color(0, 0, 0)); // Turn off the main LED strip
+        scheduler.startOnce(nightTask, 0, millis());
+    }
+
+    void abortTick()
+    {
+        enterNightState(NIGHT_IDLE);
+    }
+
+    void pollConsole()
+    {
+        TIME_STAGE(STAGE_CONSOLE);
+        if (Serial.available())
+        {
+            powerStayAwake(); // Power-save stops the USART, which would lose the rest of the line
+        }
+        char *argv[CONSOLE_MAX_ARGS];
+        uint8_t argc = console.poll(argv);
+        if (!argc)
+        {
+            return;
+        }
 
-        if (dimming)
+        logFlush(); // Replies are plain text
+        ConsoleCommand command;
+        for (uint8_t i = 0;; i++)
         {
-            if (brightness > 0)
+            memcpy_P(&command, &commands[i], sizeof(command));
+            if (!command.name[0])
             {
-                brightness -= 5;
-                volume = max(volume - 0.3, 0.0);
-                analogWrite(LED_BUILTIN, brightness);
-                setSecondStripColor(secondStrip.Color(brightness, 0, 0)); // Adjust brightness on the second LED strip
-                mp3.setVolume(static_cast<int>(volume));
-                Serial.print("Dimming... Brightness: ");
-                Serial.print(brightness);
-                Serial.print(", Volume: ");
-                Serial.println(volume);
-                delay(100);
+                Serial.println(F("error: unknown command, try help"));
+                return;
             }
-            else
+            if (!strcmp(argv[0], command.name))
             {
-                dimming = false;
-                setSecondStripColor(secondStrip.Color(0, 0, 0)); // Turn off the second LED strip
-                mp3.setVolume(0);
-                Serial.println("Dimming complete: Light and volume turned off. Good night!");
+                (this->*command.handler)(argc, argv);
+                return;
+            }
+        }
+    }
 
-                // Wait for 5 seconds
-                delay(5000);
-                Serial.println("Starting brighting process...");
+    // Points value at the setting called name and gives its range
+    bool findSetting(const char *name, int *&value, int &low, int &high)
+    {
+        if (!strcmp_P(name, PSTR("wakeupTime")))
+        {
+            value = &wakeupTime;
+            low = 1;
+            high = 8;
+        }
+        else if (!strcmp_P(name, PSTR("redLightTime")))
+        {
+            value = &redLightTime;
+            low = 1;
+            high = 30;
+        }
+        else if (!strcmp_P(name, PSTR("musicIndex")))
+        {
+            value = &musicIndex;
+            low = 1;
+            high = 255;
+        }
+        else
+        {
+            Serial.println(F("error: settings are wakeupTime, redLightTime, musicIndex"));
+            return false;
+        }
+        return true;
+    }
 
-                // Increment LED brightness from 0 to orange and nature sounds volume from 0 to 10
-                int red = 0;
-                int green = 0;
-                volume = 0;
-                while (volume < 10)
-                {
-                    volume += 0.2;
-                    red += 5;
-                    green += 1;
-                    mp3.setVolume(volume);
-                    setSecondStripColor(secondStrip.Color(red, green, 0)); // Update second LED strip
-                    Serial.print("Volume: ");
-                    Serial.print(volume);
-                    Serial.print(", Red: ");
-                    Serial.print(red);
-                    Serial.print(", Green: ");
-                    Serial.println(green);
-                    delay(100);
-                }
-                volume = 10;
-                mp3.setVolume(volume);
-                setSecondStripColor(secondStrip.Color(red, green, 0)); // Orange light on the second LED strip
-                Serial.print("Volume: ");
-                Serial.print(volume);
-                Serial.print(", Red: ");
-                Serial.print(red);
-                Serial.print(", Green: ");
-                Serial.println(green);
-                
-                
-                if (digitalRead(PRESSURE_BUTTON) == HIGH) {
-                    while (digitalRead(PRESSURE_BUTTON) == HIGH)
-                        {
-                            Serial.println("Program completed. Holding down button.");
-                        }
-                } else {
-                    dimming = false;
-                    mp3.setVolume(0);
-                }
-            } 
+    void commandHelp(uint8_t, char **)
+    {
+        Serial.println(F("get NAME | set NAME VALUE | sunrise | stats | log LEVEL"));
+#ifdef TIMING_ENABLED
+        Serial.println(F("timing"));
+#endif
+    }
+
+    void commandGet(uint8_t argc, char **argv)
+    {
+        int *value;
+        int low;
+        int high;
+        if (argc < 2 || !findSetting(argv[1], value, low, high))
+        {
+            return;
         }
+        Serial.println(*value);
     }
 
-    void setStripColor(uint32_t color)
+    void commandSet(uint8_t argc, char **argv)
     {
-        for (int i = 0; i < NUMPIXELS; i++)
+        int *value;
+        int low;
+        int high;
+        if (argc < 3 || !findSetting(argv[1], value, low, high))
+        {
+            return;
+        }
+        int requested = atoi(argv[2]);
+        if (requested < low || requested > high)
         {
-            strip.setPixelColor(i, color);
+            Serial.print(F("error: range is "));
+            Serial.print(low);
+            Serial.print('-');
+            Serial.println(high);
+            return;
         }
-        strip.show();
+
+        *value = requested;
+        releaseKnob();
+        saveSettings();
+        if (value == &wakeupTime && nightState == NIGHT_DARK)
+        {
+            scheduleWakeup();
+        }
+        Serial.println(F("ok"));
     }
 
-    void setSecondStripColor(uint32_t color)
+    // Skips the rest of the night, or plays a sunrise from idle
+    void commandSunrise(uint8_t, char **)
     {
-        for (int i = 0; i < SECOND_NUMPIXELS; i++)
+        if (nightState != NIGHT_IDLE && nightState != NIGHT_DARK)
         {
-            secondStrip.setPixelColor(i, color);
+            Serial.println(F("error: only from idle or dark"));
+            return;
         }
-        secondStrip.show();
+        enterNightState(NIGHT_SUNRISE);
+        Serial.println(F("ok"));
     }
+
+    void commandStats(uint8_t, char **)
+    {
+        printStats();
+    }
+
+    void commandLog(uint8_t argc, char **argv)
+    {
+        if (argc < 2)
+        {
+            Serial.println(logLevel);
+            return;
+        }
+        logSetLevel(atoi(argv[1]));
+        Serial.println(logLevel);
+    }
+
+#ifdef TIMING_ENABLED
+    void commandTiming(uint8_t, char **)
+    {
+        timingReport(Serial);
+    }
+#endif
+
+    // Both strips sit on one port, so their due frames go out in one pass;
+    // elsewhere they are sent in the background where the backend allows
+    void showStrips()
+    {
+        Adafruit_NeoPixel *due[2];
+        uint8_t count = 0;
+        if (stripRenderer.takeFrame())
+        {
+            due[count++] = &strip;
+        }
+        if (secondStripRenderer.takeFrame())
+        {
+            due[count++] = &secondStrip;
+        }
+        if (count)
+        {
+            TIME_STAGE(STAGE_SHOW_STRIPS);
+            Adafruit_NeoPixel::showGroup(due, count);
+        }
+    }
+
+    void setStripColor(uint32_t color)
+    {
+        stripRenderer.fill(color);
+    }
+
+    void setSecondStripColor(uint32_t color)
+    {
+        secondStripRenderer.fill(color);
+    }
+};
+
+template <class Board>
+const typename LightAndMusicController<Board>::NightStateHandlers LightAndMusicController<Board>::nightStates[NIGHT_STATE_COUNT] PROGMEM = {
+    // {entry, tick, exit, whilePressed, whileReleased}
+    {0, 0, 0, NIGHT_INTRO, NIGHT_STAY},
+    {&LightAndMusicController::introEntry, &LightAndMusicController::introTick, 0, NIGHT_STAY, NIGHT_ABORT},
+    {&LightAndMusicController::dimmingEntry, &LightAndMusicController::dimmingTick, 0, NIGHT_STAY, NIGHT_ABORT},
+    {&LightAndMusicController::darkEntry, &LightAndMusicController::darkTick, &LightAndMusicController::darkExit, NIGHT_STAY, NIGHT_STAY},
+    {&LightAndMusicController::sunriseEntry, &LightAndMusicController::sunriseTick, 0, NIGHT_STAY, NIGHT_STAY},
+    {&LightAndMusicController::holdEntry, 0, 0, NIGHT_STAY, NIGHT_IDLE},
+    {&LightAndMusicController::abortEntry, &LightAndMusicController::abortTick, 0, NIGHT_STAY, NIGHT_STAY},
+};
+
+template <class Board>
+const typename LightAndMusicController<Board>::ConsoleCommand LightAndMusicController<Board>::commands[] PROGMEM = {
+    {"help", &LightAndMusicController::commandHelp},
+    {"get", &LightAndMusicController::commandGet},
+    {"set", &LightAndMusicController::commandSet},
+    {"sunrise", &LightAndMusicController::commandSunrise},
+    {"stats", &LightAndMusicController::commandStats},
+    {"log", &LightAndMusicController::commandLog},
+#ifdef TIMING_ENABLED
+    {"timing", &LightAndMusicController::commandTiming},
+#endif
+    {"", 0},
 };
 
-LightAndMusicController controller(MP3_RX, MP3_TX, NEOPIXEL_PIN, NUMPIXELS, SECOND_STRIP_PIN, SECOND_NUMPIXELS);
+LightAndMusicController<UnoBoard> controller;
 
 void setup()
 {
@@ -277,4 +887,4 @@ void setup()
 void loop()
 {
     controller.update();
-}
\ No newline at end of file
+}
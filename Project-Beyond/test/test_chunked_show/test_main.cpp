@@ -0,0 +1,124 @@
+// Host tests for chunked show() (setInterruptWindow()) against a long
+// interrupt handler between chunks, like SoftwareSerial receiving a byte
+// from the MP3 module, and for StripRenderer sending the cut-short frame
+// again.
+//
+//   pio test -e native
+
+#include <unity.h>
+#include "HostHAL.h"
+#include "StripRenderer.h"
+
+#define TEST_PIN 7
+#define TEST_LENGTH 15
+#define TEST_WINDOW_US 60           // As main.cpp sets: two pixels a chunk
+#define TEST_SERIAL_BYTE_US 1042    // SoftwareSerial's receive handler at 9600 baud
+#define TEST_TIMER_TICK_US 8        // Timer0's overflow handler, roughly
+#define TEST_LATCH_US 300
+
+static StaticNeoPixel<TEST_LENGTH> strip(TEST_PIN);
+
+// Colour of pixel n as the strip last latched it
+static uint32_t shownColor(uint16_t n)
+{
+    uint32_t numBytes;
+    const uint8_t *frame = halGetFrame(TEST_PIN, &numBytes);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(strip.numPixels() * 3, numBytes);
+    const uint8_t *p = &frame[n * 3]; // GRB
+    return Adafruit_NeoPixel::Color(p[1], p[0], p[2]);
+}
+
+// Sends a frame of one colour that nothing interrupts
+static void showWhole(uint32_t color)
+{
+    strip.fill(color);
+    strip.show();
+    halAdvanceMicros(TEST_LATCH_US);
+}
+
+void setUp(void)
+{
+    strip.setInterruptWindow(TEST_WINDOW_US);
+    showWhole(0xFF0000);
+}
+
+void tearDown(void)
+{
+}
+
+void test_window_sends_whole_frame(void)
+{
+    uint16_t aborted = strip.getAbortedShows();
+    uint32_t shows = halGetShowCount(TEST_PIN);
+
+    showWhole(0x00FF00);
+    TEST_ASSERT_EQUAL_UINT16(aborted, strip.getAbortedShows());
+    TEST_ASSERT_EQUAL_UINT32(shows + 1, halGetShowCount(TEST_PIN));
+    for (uint16_t i = 0; i < TEST_LENGTH; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX32(0x00FF00, shownColor(i));
+    }
+}
+
+void test_short_interrupt_keeps_frame(void)
+{
+    uint16_t aborted = strip.getAbortedShows();
+
+    halInjectInterrupt(0, TEST_TIMER_TICK_US);
+    showWhole(0x0000FF);
+    TEST_ASSERT_EQUAL_UINT16(aborted, strip.getAbortedShows());
+    TEST_ASSERT_EQUAL_HEX32(0x0000FF, shownColor(TEST_LENGTH - 1));
+}
+
+void test_serial_byte_aborts_frame(void)
+{
+    uint16_t aborted = strip.getAbortedShows();
+
+    // The byte arrives during the first chunk; its handler runs at the
+    // first resume and the strip latches after two pixels
+    halInjectInterrupt(0, TEST_SERIAL_BYTE_US);
+    showWhole(0x00FF00);
+    TEST_ASSERT_EQUAL_UINT16(aborted + 1, strip.getAbortedShows());
+    TEST_ASSERT_EQUAL_HEX32(0x00FF00, shownColor(0));
+    TEST_ASSERT_EQUAL_HEX32(0x00FF00, shownColor(1));
+    TEST_ASSERT_EQUAL_HEX32(0xFF0000, shownColor(2));
+    TEST_ASSERT_EQUAL_HEX32(0xFF0000, shownColor(TEST_LENGTH - 1));
+}
+
+void test_renderer_resends_aborted_frame(void)
+{
+    StripRenderer<TEST_LENGTH> renderer(strip);
+    renderer.takeFrame(); // Catches up with the earlier tests' aborts
+
+    renderer.fill(0x00FF00);
+    TEST_ASSERT_TRUE(renderer.takeFrame());
+    halInjectInterrupt(0, TEST_SERIAL_BYTE_US);
+    strip.show();
+    halAdvanceMicros(TEST_LATCH_US);
+    TEST_ASSERT_EQUAL_HEX32(0xFF0000, shownColor(TEST_LENGTH - 1));
+
+    // Nothing was drawn since, but the frame goes out again
+    TEST_ASSERT_TRUE(renderer.takeFrame());
+    strip.show();
+    halAdvanceMicros(TEST_LATCH_US);
+    for (uint16_t i = 0; i < TEST_LENGTH; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX32(0x00FF00, shownColor(i));
+    }
+
+    // And only once
+    renderer.fill(0x00FF00);
+    TEST_ASSERT_FALSE(renderer.takeFrame());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    strip.begin();
+    RUN_TEST(test_window_sends_whole_frame);
+    RUN_TEST(test_short_interrupt_keeps_frame);
+    RUN_TEST(test_serial_byte_aborts_frame);
+    RUN_TEST(test_renderer_resends_aborted_frame);
+    return UNITY_END();
+}
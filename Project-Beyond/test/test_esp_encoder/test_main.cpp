@@ -0,0 +1,138 @@
+// Host tests for the ESP32 RMT symbol encoder in esp.c, which builds
+// without ESP-IDF under NEOPIXEL_HOST.
+//
+//   pio test -e native
+
+#include <unity.h>
+#include "esp_encoder.h"
+
+#define TEST_RESOLUTION_HZ 10000000 // 100 ns ticks, as esp.c uses
+#define TEST_RESET_NS 300000
+
+// Symbol fields, laid out as rmt_symbol_word_t
+static uint32_t duration0(uint32_t symbol) { return symbol & 0x7FFF; }
+static uint32_t level0(uint32_t symbol) { return (symbol >> 15) & 1; }
+static uint32_t duration1(uint32_t symbol) { return (symbol >> 16) & 0x7FFF; }
+static uint32_t level1(uint32_t symbol) { return symbol >> 31; }
+
+static uint32_t bit0, bit1, reset;
+
+void setUp(void)
+{
+    bit0 = espSymbol(400, 850, TEST_RESOLUTION_HZ); // WS2812 timings
+    bit1 = espSymbol(800, 450, TEST_RESOLUTION_HZ);
+    reset = espResetSymbol(TEST_RESET_NS, TEST_RESOLUTION_HZ);
+}
+
+void tearDown(void)
+{
+}
+
+void test_800khz_timings(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(4, duration0(bit0));
+    TEST_ASSERT_EQUAL_UINT32(1, level0(bit0));
+    TEST_ASSERT_EQUAL_UINT32(9, duration1(bit0)); // 8.5 ticks rounds up
+    TEST_ASSERT_EQUAL_UINT32(0, level1(bit0));
+
+    TEST_ASSERT_EQUAL_UINT32(8, duration0(bit1));
+    TEST_ASSERT_EQUAL_UINT32(1, level0(bit1));
+    TEST_ASSERT_EQUAL_UINT32(5, duration1(bit1));
+    TEST_ASSERT_EQUAL_UINT32(0, level1(bit1));
+}
+
+void test_400khz_timings(void)
+{
+    uint32_t slow0 = espSymbol(500, 2000, TEST_RESOLUTION_HZ); // WS2811 timings
+    uint32_t slow1 = espSymbol(1200, 1300, TEST_RESOLUTION_HZ);
+
+    TEST_ASSERT_EQUAL_UINT32(5, duration0(slow0));
+    TEST_ASSERT_EQUAL_UINT32(20, duration1(slow0));
+    TEST_ASSERT_EQUAL_UINT32(12, duration0(slow1));
+    TEST_ASSERT_EQUAL_UINT32(13, duration1(slow1));
+    TEST_ASSERT_EQUAL_UINT32(1, level0(slow1));
+    TEST_ASSERT_EQUAL_UINT32(0, level1(slow1));
+
+    // Each bit lasts 2.5 us
+    TEST_ASSERT_EQUAL_UINT32(25, duration0(slow0) + duration1(slow0));
+    TEST_ASSERT_EQUAL_UINT32(25, duration0(slow1) + duration1(slow1));
+}
+
+void test_bits_go_msb_first(void)
+{
+    const uint8_t pixels[] = {0xA5, 0x0F};
+    const uint8_t expected[] = {1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 1, 1, 1};
+    uint32_t symbols[17];
+    bool done = false;
+
+    size_t n = espEncodeSymbols(pixels, sizeof(pixels), 0, symbols, 17, bit0, bit1, reset, &done);
+    TEST_ASSERT_EQUAL(17, n);
+    TEST_ASSERT_TRUE(done);
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX32(expected[i] ? bit1 : bit0, symbols[i]);
+    }
+}
+
+void test_partial_buffer_resumes_mid_byte(void)
+{
+    const uint8_t pixels[] = {0x96, 0x3C, 0xE1};
+    uint32_t whole[25], pieces[25];
+    bool done = false;
+    espEncodeSymbols(pixels, sizeof(pixels), 0, whole, 25, bit0, bit1, reset, &done);
+
+    // Three symbols at a time, as a nearly full RMT memory block would take
+    size_t position = 0;
+    done = false;
+    while (!done)
+    {
+        size_t n = espEncodeSymbols(pixels, sizeof(pixels), position, &pieces[position], 3, bit0, bit1, reset, &done);
+        TEST_ASSERT_GREATER_THAN(0, n);
+        position += n;
+        TEST_ASSERT_TRUE(done == (position == 25));
+    }
+    TEST_ASSERT_EQUAL(25, position);
+    for (uint8_t i = 0; i < 25; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX32(whole[i], pieces[i]);
+    }
+
+    // No room, no progress
+    done = true;
+    TEST_ASSERT_EQUAL(0, espEncodeSymbols(pixels, sizeof(pixels), 4, pieces, 0, bit0, bit1, reset, &done));
+    TEST_ASSERT_FALSE(done);
+}
+
+void test_reset_symbol_ends_the_frame(void)
+{
+    // The line stays low for the whole latch time
+    TEST_ASSERT_EQUAL_UINT32(0, level0(reset));
+    TEST_ASSERT_EQUAL_UINT32(0, level1(reset));
+    TEST_ASSERT_EQUAL_UINT32(TEST_RESET_NS / 100, duration0(reset) + duration1(reset));
+
+    // It follows the last bit, and the frame is done only once it is out
+    const uint8_t pixels[] = {0xFF};
+    uint32_t symbols[9];
+    bool done = true;
+    TEST_ASSERT_EQUAL(8, espEncodeSymbols(pixels, 1, 0, symbols, 8, bit0, bit1, reset, &done));
+    TEST_ASSERT_FALSE(done);
+    TEST_ASSERT_EQUAL(1, espEncodeSymbols(pixels, 1, 8, &symbols[8], 1, bit0, bit1, reset, &done));
+    TEST_ASSERT_TRUE(done);
+    TEST_ASSERT_EQUAL_HEX32(reset, symbols[8]);
+
+    // An empty frame is just the reset
+    TEST_ASSERT_EQUAL(1, espEncodeSymbols(pixels, 0, 0, symbols, 9, bit0, bit1, reset, &done));
+    TEST_ASSERT_TRUE(done);
+    TEST_ASSERT_EQUAL_HEX32(reset, symbols[0]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_800khz_timings);
+    RUN_TEST(test_400khz_timings);
+    RUN_TEST(test_bits_go_msb_first);
+    RUN_TEST(test_partial_buffer_resumes_mid_byte);
+    RUN_TEST(test_reset_symbol_ends_the_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,135 @@
+// Drives the controller through the host HAL: the virtual clock, and the
+// night cycle starting on a pressure button press. The tests share one
+// controller and run in order, each picking up where the last one left it.
+//
+//   pio test -e native
+
+#include <unity.h>
+#include "HostHAL.h"
+
+#define TEST_PRESSURE_PIN 2
+#define TEST_STRIP_PIN 4
+#define TEST_SECOND_STRIP_PIN 5
+#define TEST_STEP_US 1000UL
+
+void setup(void);
+void loop(void);
+
+// Runs loop() for ms of true time, skipping ahead whenever the firmware
+// reports it is idle, as the simulation does
+static void runFor(uint32_t ms)
+{
+    uint64_t end = halNowMicros() + (uint64_t)ms * 1000;
+    while (halNowMicros() < end)
+    {
+        uint64_t before = halNowMicros();
+        loop();
+
+        uint64_t idleUntil;
+        if (halTakeIdle(&idleUntil))
+        {
+            if (idleUntil > end)
+            {
+                idleUntil = end;
+            }
+            if (idleUntil > halNowMicros())
+            {
+                halAdvanceMicros(idleUntil - halNowMicros());
+            }
+            continue;
+        }
+
+        uint64_t spent = halNowMicros() - before;
+        if (spent < TEST_STEP_US)
+        {
+            halAdvanceMicros(TEST_STEP_US - spent);
+        }
+    }
+}
+
+// First pixel of the last frame sent on pin, as sent: GRB
+static void firstPixel(int16_t pin, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    uint32_t numBytes;
+    const uint8_t *frame = halGetFrame(pin, &numBytes);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_GREATER_THAN(2, numBytes);
+    g = frame[0];
+    r = frame[1];
+    b = frame[2];
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_clock_advances_only_when_told(void)
+{
+    unsigned long start = millis();
+    TEST_ASSERT_EQUAL_UINT32(start, millis());
+
+    halAdvanceMicros(250000);
+    TEST_ASSERT_EQUAL_UINT32(start + 250, millis());
+
+    // Each micros() call costs a little time, so busy-waits make progress
+    unsigned long first = micros();
+    TEST_ASSERT_GREATER_THAN(first, micros());
+}
+
+void test_idle_shows_white(void)
+{
+    setup();
+    runFor(500);
+
+    uint8_t r, g, b;
+    firstPixel(TEST_SECOND_STRIP_PIN, r, g, b);
+    // White, scaled down by the current limit; dithering may put channels
+    // one step apart on any one frame
+    TEST_ASSERT_GREATER_THAN(0, r);
+    TEST_ASSERT_UINT8_WITHIN(1, r, g);
+    TEST_ASSERT_UINT8_WITHIN(1, r, b);
+}
+
+void test_press_plays_intro_first(void)
+{
+    halSetPin(TEST_PRESSURE_PIN, HIGH);
+    runFor(1000);
+
+    // The intro sound plays before any dimming: the light is still white
+    uint8_t r, g, b;
+    firstPixel(TEST_SECOND_STRIP_PIN, r, g, b);
+    TEST_ASSERT_UINT8_WITHIN(1, r, g);
+    TEST_ASSERT_UINT8_WITHIN(1, r, b);
+}
+
+void test_intro_leads_to_red_dimming(void)
+{
+    runFor(3000); // Past the intro sound and the start of the dimming
+
+    uint8_t r, g, b;
+    firstPixel(TEST_SECOND_STRIP_PIN, r, g, b);
+    TEST_ASSERT_GREATER_THAN(0, r);
+    TEST_ASSERT_EQUAL_UINT8(0, g);
+    TEST_ASSERT_EQUAL_UINT8(0, b);
+
+    // The main strip is turned off
+    firstPixel(TEST_STRIP_PIN, r, g, b);
+    TEST_ASSERT_EQUAL_UINT8(0, r);
+    TEST_ASSERT_EQUAL_UINT8(0, g);
+    TEST_ASSERT_EQUAL_UINT8(0, b);
+}
+
+int main(int argc, char **argv)
+{
+    halMuteSerial(true); // The binary log would garble the test report
+    UNITY_BEGIN();
+    RUN_TEST(test_clock_advances_only_when_told);
+    RUN_TEST(test_idle_shows_white);
+    RUN_TEST(test_press_plays_intro_first);
+    RUN_TEST(test_intro_leads_to_red_dimming);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+// Host tests for the RP2040 DMA word packing in rp2040_pack.h, which has
+// no Pico SDK dependencies.
+//
+//   pio test -e native
+
+#include <unity.h>
+#include "rp2040_pack.h"
+
+#define TEST_MAX_BYTES 48 // 16 RGB pixels, or 12 RGBW
+
+static uint8_t pixels[TEST_MAX_BYTES];
+
+void setUp(void)
+{
+    // Distinct, nonzero bytes so a misplaced or dropped one shows
+    for (uint8_t i = 0; i < TEST_MAX_BYTES; i++)
+    {
+        pixels[i] = 0x11 + i * 5;
+    }
+}
+
+void tearDown(void)
+{
+}
+
+void test_first_byte_is_most_significant(void)
+{
+    const uint8_t grb[] = {0x12, 0x34, 0x56, 0x78};
+    TEST_ASSERT_EQUAL_UINT32(1, rp2040PackedWords(sizeof(grb)));
+    TEST_ASSERT_EQUAL_HEX32(0x12345678, rp2040PackWord(grb, sizeof(grb), 0));
+
+    uint32_t word;
+    rp2040PackWords(grb, sizeof(grb), &word);
+    TEST_ASSERT_EQUAL_HEX32(0x12345678, word);
+}
+
+void test_whole_words(void)
+{
+    for (uint32_t numBytes = 4; numBytes <= TEST_MAX_BYTES; numBytes += 4)
+    {
+        TEST_ASSERT_EQUAL_UINT32(numBytes / 4, rp2040PackedWords(numBytes));
+
+        uint32_t words[TEST_MAX_BYTES / 4];
+        rp2040PackWords(pixels, numBytes, words);
+        for (uint32_t w = 0; w < numBytes / 4; w++)
+        {
+            uint32_t expected = ((uint32_t)pixels[w * 4] << 24) | ((uint32_t)pixels[w * 4 + 1] << 16) |
+                                ((uint32_t)pixels[w * 4 + 2] << 8) | pixels[w * 4 + 3];
+            TEST_ASSERT_EQUAL_HEX32(expected, words[w]);
+        }
+    }
+}
+
+void test_short_last_word_is_zero_padded(void)
+{
+    const uint8_t rgb[] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x01};
+    uint32_t words[2];
+
+    // One, two and three bytes left over
+    TEST_ASSERT_EQUAL_UINT32(2, rp2040PackedWords(5));
+    rp2040PackWords(rgb, 5, words);
+    TEST_ASSERT_EQUAL_HEX32(0xAABBCCDD, words[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xEE000000, words[1]);
+
+    TEST_ASSERT_EQUAL_UINT32(2, rp2040PackedWords(6));
+    rp2040PackWords(rgb, 6, words);
+    TEST_ASSERT_EQUAL_HEX32(0xEEFF0000, words[1]);
+
+    TEST_ASSERT_EQUAL_UINT32(2, rp2040PackedWords(7));
+    rp2040PackWords(rgb, 7, words);
+    TEST_ASSERT_EQUAL_HEX32(0xEEFF0100, words[1]);
+
+    // A single RGB pixel fits in one padded word
+    TEST_ASSERT_EQUAL_UINT32(1, rp2040PackedWords(3));
+    TEST_ASSERT_EQUAL_HEX32(0xAABBCC00, rp2040PackWord(rgb, 3, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, rp2040PackedWords(0));
+}
+
+void test_pack_words_matches_pack_word(void)
+{
+    for (uint32_t numBytes = 1; numBytes <= TEST_MAX_BYTES; numBytes++)
+    {
+        uint32_t count = rp2040PackedWords(numBytes);
+        uint32_t words[TEST_MAX_BYTES / 4 + 1];
+        words[count] = 0xDEADBEEF; // Guard: nothing past the last word is written
+        rp2040PackWords(pixels, numBytes, words);
+
+        for (uint32_t w = 0; w < count; w++)
+        {
+            TEST_ASSERT_EQUAL_HEX32(rp2040PackWord(pixels, numBytes, w), words[w]);
+        }
+        TEST_ASSERT_EQUAL_HEX32(0xDEADBEEF, words[count]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_byte_is_most_significant);
+    RUN_TEST(test_whole_words);
+    RUN_TEST(test_short_last_word_is_zero_padded);
+    RUN_TEST(test_pack_words_matches_pack_word);
+    return UNITY_END();
+}
@@ -0,0 +1,109 @@
+// Host tests for WallClock's RTC discipline, driven by a mock RTC rather
+// than the simulator's, so the RTC can be stepped like a user setting it.
+//
+//   pio test -e native
+
+#include <unity.h>
+#include "WallClock.h"
+
+#define TEST_SLOW_PPM 1000             // The resonator's ticks run this slow
+#define TEST_START_SECONDS 700000000UL // Some time in 2022
+#define TEST_HOUR_MS 3600000UL
+
+// RTC reading true time, which the ticks fall behind by TEST_SLOW_PPM
+class MockRtc : public RtcSource
+{
+public:
+    int32_t offset; // Seconds the RTC has been set away from true time
+
+    bool read(uint32_t &seconds)
+    {
+        uint64_t trueMs = (uint64_t)ticks * (1000000 + TEST_SLOW_PPM) / 1000000;
+        seconds = TEST_START_SECONDS + (uint32_t)(trueMs / 1000) + offset;
+        return true;
+    }
+
+    uint32_t ticks;
+};
+
+static MockRtc rtc;
+static WallClock wallClock;
+
+// Advances the ticks, consulting the RTC as often as the controller does
+static void runFor(uint32_t ms)
+{
+    uint32_t end = rtc.ticks + ms;
+    while (rtc.ticks != end)
+    {
+        uint32_t step = end - rtc.ticks > CLOCK_DISCIPLINE_MS ? CLOCK_DISCIPLINE_MS : end - rtc.ticks;
+        rtc.ticks += step;
+        wallClock.advance(rtc.ticks);
+        wallClock.discipline(rtc.ticks);
+    }
+}
+
+void setUp(void)
+{
+    rtc.ticks = 0;
+    rtc.offset = 0;
+    wallClock = WallClock();
+    wallClock.begin(0, &rtc);
+}
+
+void tearDown(void)
+{
+}
+
+void test_trim_estimate(void)
+{
+    TEST_ASSERT_TRUE(wallClock.isSynced());
+    runFor(10 * TEST_HOUR_MS);
+    TEST_ASSERT_INT_WITHIN(100, TEST_SLOW_PPM, wallClock.getTrim());
+}
+
+void test_forward_jump_keeps_trim(void)
+{
+    runFor(10 * TEST_HOUR_MS);
+    int16_t trim = wallClock.getTrim();
+
+    // Set hours ahead: the implied ppm is far out of range, and the
+    // millisecond error alone overflows 32 bits once scaled
+    rtc.offset = 5 * 3600L;
+    runFor(CLOCK_DISCIPLINE_MS);
+    TEST_ASSERT_EQUAL_INT16(trim, wallClock.getTrim());
+
+    uint32_t rtcSeconds;
+    rtc.read(rtcSeconds);
+    TEST_ASSERT_EQUAL_UINT32(rtcSeconds, wallClock.now(rtc.ticks));
+
+    // Measured afresh from the new setting
+    runFor(10 * TEST_HOUR_MS);
+    TEST_ASSERT_INT_WITHIN(100, TEST_SLOW_PPM, wallClock.getTrim());
+}
+
+void test_backward_step_keeps_trim(void)
+{
+    runFor(10 * TEST_HOUR_MS);
+    int16_t trim = wallClock.getTrim();
+
+    // Set to before the measurement began
+    rtc.offset = -2 * 86400L;
+    runFor(CLOCK_DISCIPLINE_MS);
+    TEST_ASSERT_EQUAL_INT16(trim, wallClock.getTrim());
+
+    uint32_t rtcSeconds;
+    rtc.read(rtcSeconds);
+    TEST_ASSERT_EQUAL_UINT32(rtcSeconds, wallClock.now(rtc.ticks));
+
+    runFor(10 * TEST_HOUR_MS);
+    TEST_ASSERT_INT_WITHIN(100, TEST_SLOW_PPM, wallClock.getTrim());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_trim_estimate);
+    RUN_TEST(test_forward_jump_keeps_trim);
+    RUN_TEST(test_backward_step_keeps_trim);
+    return UNITY_END();
+}
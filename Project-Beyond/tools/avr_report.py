@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Report the Uno build's flash/RAM use against a baseline, and ISR cycles.
+
+Builds env:uno for the working tree and for a baseline git ref (checked out
+in a temporary worktree), prints avr-size for both, then disassembles the
+button interrupt path of the working tree's build and counts its cycles.
+Needs PlatformIO with the atmelavr platform installed (avr-size and
+avr-objdump come with its toolchain).
+
+    python3 tools/avr_report.py --baseline 9fc1df3^
+    python3 tools/avr_report.py --baseline v1.0 --symbol 'MP3::'
+
+Cycle counts are for the ATmega328P and straight-line: every instruction
+once, branches and skips not taken. Loops and taken paths cost more, and
+calls are listed so their targets can be added (micros() is in the
+report by default).
+"""
+
+import argparse
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ENV = "uno"
+
+# Functions on the path of a button edge: the core's INT0/INT1 vectors,
+# which call the attached handler through a pointer, the per-pin handlers
+# and what they call
+DEFAULT_SYMBOLS = [
+    "<__vector_1>",
+    "<__vector_2>",
+    "ButtonInput::onEdge<",
+    "ButtonInput::pushEdge(",
+    "<micros>",
+    "powerWake()",
+]
+
+# ATmega328P cycles per mnemonic (22-bit PC devices differ for calls and
+# returns). Anything not listed takes one cycle.
+CYCLES = {
+    "adiw": 2, "sbiw": 2, "mul": 2, "muls": 2, "mulsu": 2,
+    "fmul": 2, "fmuls": 2, "fmulsu": 2,
+    "ld": 2, "ldd": 2, "lds": 2, "st": 2, "std": 2, "sts": 2,
+    "push": 2, "pop": 2, "sbi": 2, "cbi": 2,
+    "lpm": 3, "elpm": 3, "spm": 4,
+    "rjmp": 2, "ijmp": 2, "jmp": 3,
+    "rcall": 3, "icall": 3, "call": 4,
+    "ret": 4, "reti": 4,
+}
+CALLS = ("rcall", "icall", "call")
+
+
+def run(cmd, cwd=None):
+    return subprocess.run(cmd, cwd=cwd, check=True, stdout=subprocess.PIPE,
+                          universal_newlines=True).stdout
+
+
+def tool(name, project):
+    """Path to an avr toolchain binary installed by PlatformIO."""
+    found = shutil.which(name)
+    if found:
+        return found
+    home = os.environ.get("PLATFORMIO_CORE_DIR", os.path.expanduser("~/.platformio"))
+    matches = glob.glob(os.path.join(home, "packages", "toolchain-atmelavr*", "bin", name))
+    if not matches:
+        sys.exit("%s not found; run `pio run -e %s` once to install the toolchain" % (name, ENV))
+    return matches[0]
+
+
+def build(project):
+    run(["pio", "run", "-s", "-e", ENV], cwd=project)
+    return os.path.join(project, ".pio", "build", ENV, "firmware.elf")
+
+
+def size(elf, project):
+    """(text, data, bss) in bytes."""
+    out = run([tool("avr-size", project), elf]).splitlines()
+    text, data, bss = (int(v) for v in out[1].split()[:3])
+    return text, data, bss
+
+
+def functions(elf, project):
+    """Disassembly per function: name -> list of (mnemonic, operands, comment)."""
+    out = run([tool("avr-objdump", project), "-d", "-C", "--no-show-raw-insn", elf])
+    result, current = {}, None
+    for line in out.splitlines():
+        header = re.match(r"^[0-9a-f]+ <(.*)>:$", line)
+        if header:
+            current = result.setdefault("<%s>" % header.group(1), [])
+            continue
+        insn = re.match(r"^\s+[0-9a-f]+:\s+(\w+)\s*([^;]*)(?:;\s*(.*))?", line)
+        if insn and current is not None:
+            current.append((insn.group(1), insn.group(2).strip(), insn.group(3) or ""))
+    return result
+
+
+def cycles(body):
+    return sum(CYCLES.get(insn[0], 1) for insn in body)
+
+
+def report(project, baseline, symbols):
+    top = run(["git", "rev-parse", "--show-toplevel"], cwd=project).strip()
+    prefix = run(["git", "rev-parse", "--show-prefix"], cwd=project).strip()
+
+    worktree = tempfile.mkdtemp(prefix="avr_report_")
+    try:
+        run(["git", "worktree", "add", "--detach", worktree, baseline], cwd=top)
+        before = size(build(os.path.join(worktree, prefix)), project)
+    finally:
+        subprocess.call(["git", "worktree", "remove", "--force", worktree], cwd=top)
+        shutil.rmtree(worktree, ignore_errors=True)
+
+    elf = build(project)
+    after = size(elf, project)
+
+    print("%-10s %8s %8s %8s" % ("", "flash", "ram", "bss"))
+    print("%-10s %8d %8d %8d" % (baseline, before[0] + before[1], before[1] + before[2], before[2]))
+    print("%-10s %8d %8d %8d" % ("working", after[0] + after[1], after[1] + after[2], after[2]))
+    print("%-10s %+8d %+8d %+8d" % ("change", after[0] + after[1] - before[0] - before[1],
+                                    after[1] + after[2] - before[1] - before[2], after[2] - before[2]))
+    print()
+
+    disassembly = functions(elf, project)
+    for symbol in symbols:
+        for name in sorted(n for n in disassembly if symbol in n):
+            body = disassembly[name]
+            calls = [" ".join(insn).strip() for insn in body if insn[0] in CALLS]
+            print("%5d cycles  %3d instructions  %s" % (cycles(body), len(body), name))
+            for call in calls:
+                print("%30s%s" % ("", call))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--baseline", required=True, help="git ref to compare against")
+    parser.add_argument("--symbol", action="append", default=[],
+                        help="also count cycles of functions whose name contains this")
+    args = parser.parse_args()
+
+    project = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+    report(os.path.normpath(project), args.baseline, DEFAULT_SYMBOLS + args.symbol)
+
+
+if __name__ == "__main__":
+    main()
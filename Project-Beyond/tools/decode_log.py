@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Decode the firmware's binary log records back into text.
+
+Records are 0xA5, message id, argument count, then each argument as a
+little-endian int16 (see include/Log.h). Message texts come from
+include/LogMessages.h. Plain ASCII between records (e.g. printStats()
+output) is passed through unchanged.
+
+    python3 tools/decode_log.py capture.bin
+    python3 tools/decode_log.py --port /dev/ttyACM0   # needs pyserial
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+LOG_SYNC = 0xA5
+CATALOGUE = os.path.join(os.path.dirname(__file__), "..", "include", "LogMessages.h")
+
+
+def load_messages(path):
+    with open(path) as f:
+        source = f.read()
+    return [text.encode().decode("unicode_escape")
+            for _, text in re.findall(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', source)]
+
+
+def decode(stream, messages, out):
+    pending = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        byte = chunk[0]
+        if not pending:
+            if byte == LOG_SYNC:
+                pending.append(byte)
+            elif byte < 0x80:
+                out.write(chr(byte))
+            continue
+
+        pending.append(byte)
+        if len(pending) < 3:
+            continue
+        argc = pending[2]
+        if argc > 3:
+            pending.clear()  # Lost sync
+            continue
+        if len(pending) < 3 + 2 * argc:
+            continue
+
+        msg_id = pending[1]
+        args = struct.unpack("<%dh" % argc, bytes(pending[3:]))
+        pending.clear()
+        if msg_id < len(messages):
+            out.write(messages[msg_id].replace("{}", "%d") % args + "\n")
+        else:
+            out.write("<unknown message %d %s>\n" % (msg_id, list(args)))
+        out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="raw capture file (default: stdin)")
+    parser.add_argument("--port", help="read live from a serial port")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--messages", default=CATALOGUE, help="path to LogMessages.h")
+    args = parser.parse_args()
+
+    messages = load_messages(args.messages)
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+    elif args.capture:
+        stream = open(args.capture, "rb")
+    else:
+        stream = sys.stdin.buffer
+    decode(stream, messages, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()